@@ -0,0 +1,178 @@
+#include "PerfCounters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cstring>
+#endif
+
+namespace {
+
+char const* const counter_names[PerfCounters::num_counters] = {
+  "cycles",
+  "instructions",
+  "branch_misses",
+  "l1d_misses",
+};
+
+#ifdef __linux__
+// Members of a group are enabled, disabled and read with their leader
+int openCounter(uint32_t type, uint64_t config, int leader) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = leader < 0;
+  // User space only, which unprivileged processes are usually allowed
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP
+                   | PERF_FORMAT_TOTAL_TIME_ENABLED
+                   | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, leader,
+                                  0));
+}
+#endif
+
+} // anonymous namespace
+
+PerfCounters::PerfCounters() :
+  fds(),
+  leader(-1),
+  ran(false),
+  start_enabled(0),
+  start_running(0),
+  start_values(),
+  counts()
+  {
+  for (int& fd : fds) {
+    fd = -1;
+  }
+#ifdef __linux__
+  // One group, so every counter covers the same intervals and the ratios
+  // between them hold even when the kernel multiplexes
+  struct { uint32_t type; uint64_t config; } const events[num_counters] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+                          | PERF_COUNT_HW_CACHE_OP_READ << 8
+                          | PERF_COUNT_HW_CACHE_RESULT_MISS << 16 },
+  };
+  for (int i = 0; i < num_counters; ++i) {
+    fds[i] = openCounter(events[i].type, events[i].config, leader);
+    if (leader < 0) {
+      leader = fds[i];
+    }
+  }
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+  for (int fd : fds) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+#endif
+}
+
+bool PerfCounters::readGroup(uint64_t& enabled, uint64_t& running,
+                             uint64_t* values) const {
+#ifdef __linux__
+  // nr, time enabled, time running, then one value per open counter in
+  // the order they were opened
+  uint64_t buffer[3 + num_counters];
+  if (leader < 0 || read(leader, buffer, sizeof(buffer)) < 3 * 8) {
+    return false;
+  }
+  enabled = buffer[1];
+  running = buffer[2];
+  uint64_t slot = 0;
+  for (int i = 0; i < num_counters; ++i) {
+    values[i] = fds[i] >= 0 && slot < buffer[0] ? buffer[3 + slot++] : 0;
+  }
+  return true;
+#else
+  (void)enabled;
+  (void)running;
+  (void)values;
+  return false;
+#endif
+}
+
+void PerfCounters::start() {
+#ifdef __linux__
+  if (leader < 0) {
+    return;
+  }
+  // Resetting zeroes the counts but not the times, so runs are measured
+  // as differences
+  ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  if (!readGroup(start_enabled, start_running, start_values)) {
+    start_enabled = start_running = 0;
+  }
+  ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+void PerfCounters::stop() {
+  ran = false;
+  for (uint64_t& count : counts) {
+    count = 0;
+  }
+#ifdef __linux__
+  if (leader < 0) {
+    return;
+  }
+  ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  uint64_t enabled, running, values[num_counters];
+  if (!readGroup(enabled, running, values)) {
+    return;
+  }
+  enabled -= start_enabled;
+  running -= start_running;
+  // Opened, but never scheduled during this run
+  if (running == 0) {
+    return;
+  }
+  ran = true;
+  for (int i = 0; i < num_counters; ++i) {
+    double count = static_cast<double>(values[i] - start_values[i]);
+    if (running < enabled) {
+      count = count * enabled / running;
+    }
+    counts[i] = static_cast<uint64_t>(count);
+  }
+#endif
+}
+
+bool PerfCounters::available(Counter counter) const {
+  return fds[counter] >= 0;
+}
+
+bool PerfCounters::anyAvailable() const {
+  for (int fd : fds) {
+    if (fd >= 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool PerfCounters::measured(Counter counter) const {
+  return ran && fds[counter] >= 0;
+}
+
+uint64_t PerfCounters::count(Counter counter) const {
+  return counts[counter];
+}
+
+char const* PerfCounters::name(Counter counter) {
+  return counter_names[counter];
+}
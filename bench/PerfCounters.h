@@ -0,0 +1,74 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Hardware performance counters of the calling thread, read through Linux
+ * perf_event_open(). Counters the kernel or CPU does not provide, e.g. in
+ * containers or virtual machines, are left out rather than failing: check
+ * available(). On other systems none are available.
+ *
+ * The counters are opened as one group, so the kernel schedules them
+ * together and ratios between them hold under multiplexing.
+ */
+class PerfCounters {
+public:
+  enum Counter {
+    Cycles,
+    Instructions,
+    BranchMisses,
+    L1DataMisses,
+    num_counters
+  };
+
+  explicit PerfCounters();
+  PerfCounters(PerfCounters const&) = delete;
+  ~PerfCounters();
+
+  PerfCounters& operator=(PerfCounters const&) = delete;
+
+  /**
+   * Zero and start, or stop, all available counters
+   */
+  void start();
+  void stop();
+
+  /**
+   * Returns true if the counter could be opened
+   */
+  bool available(Counter counter) const;
+  bool anyAvailable() const;
+
+  /**
+   * Returns true if the counter was scheduled at all between the latest
+   * start() and stop(). Under multiplexing, or in virtual machines, an
+   * open counter may never run, and its count() means nothing.
+   */
+  bool measured(Counter counter) const;
+
+  /**
+   * Returns the count between the latest start() and stop(), scaled up if
+   * the kernel had to multiplex the counters
+   */
+  uint64_t count(Counter counter) const;
+
+  /**
+   * Short name for reports, e.g. "branch_misses"
+   */
+  static char const* name(Counter counter);
+
+private:
+  bool readGroup(uint64_t& enabled, uint64_t& running, uint64_t* values) const;
+
+  int      fds[num_counters];
+  int      leader;          // First counter opened, which leads the group
+  bool     ran;
+  uint64_t start_enabled;
+  uint64_t start_running;
+  uint64_t start_values[num_counters];
+  uint64_t counts[num_counters];
+};
+
+#endif /* PERF_COUNTERS_H */
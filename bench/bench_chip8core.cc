@@ -0,0 +1,584 @@
+#include <dirent.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "chip8core/Emulator.h"
+#include "chip8core/LockstepEmulator.h"
+#include "PerfCounters.h"
+
+#ifndef CHIP8CORE_VERSION
+#define CHIP8CORE_VERSION "unknown"
+#endif
+
+/**
+ * Microbenchmarks for chip8core. Writes one JSON document to stdout, e.g.
+ *
+ *   bench_chip8core --roms ../roms --min-time 0.5 --filter handleOpcode
+ *
+ * Every benchmark is repeated until it has run for at least min-time
+ * seconds. ROM throughput runs every file in the ROM directory with a fixed
+ * seed and key sequence, so runs are comparable between releases.
+ *
+ * Where the kernel allows it, hardware counters are read around each run
+ * (see PerfCounters.h) and reported per emulated instruction for ROMs, and
+ * per iteration otherwise. A counter which never got scheduled during a run
+ * is left out of that result. --no-perf turns them off.
+ *
+ * lockstep/ runs the first ROM as 8 and 32 independent Emulators and as a
+ * LockstepEmulator with as many lanes, and reports the step rate multiple.
+ *
+ * The context records the build type and compiler flags, since numbers
+ * from different builds do not compare. The exit status is 1 if any
+ * benchmark reported an error.
+ */
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+uint32_t constexpr bench_seed = 0xC8C8C8C8;
+
+// Results are folded into this so the compiler cannot drop the work
+volatile uint64_t sink;
+
+struct Options {
+  std::string roms_dir    = "roms";
+  std::string filter;
+  double      min_time    = 0.2;
+  uint64_t    rom_ticks   = 1000000;
+  bool        perf        = true;
+};
+
+struct Result {
+  explicit Result(std::string const& name) :
+    name(name),
+    iterations(0),
+    seconds(0.0),
+    instructions(0),
+    step_rate_multiple(0.0),
+    error(),
+    has_perf(false),
+    perf_measured(),
+    perf()
+    {}
+
+  std::string name;
+  uint64_t    iterations;
+  double      seconds;
+  uint64_t    instructions;  // Only for ROM throughput
+  double      step_rate_multiple;  // Only for lockstep, over Emulators
+  std::string error;
+  bool        has_perf;
+  bool        perf_measured[PerfCounters::num_counters];
+  uint64_t    perf[PerfCounters::num_counters];
+};
+
+void readPerf(PerfCounters const* counters, Result& result) {
+  if (counters == nullptr || !counters->anyAvailable()) {
+    return;
+  }
+  result.has_perf = true;
+  for (int i = 0; i < PerfCounters::num_counters; ++i) {
+    PerfCounters::Counter const counter = static_cast<PerfCounters::Counter>(i);
+    result.perf_measured[i] = counters->measured(counter);
+    result.perf[i] = counters->count(counter);
+  }
+}
+
+/**
+ * Gives the benchmarks access to the opcode handling and internal state
+ */
+class BenchEmulator : public Emulator {
+public:
+  using Emulator::fetchOpcode;
+  using Emulator::handleOpcode;
+  using Emulator::resetState;
+  using Emulator::registers;
+  using Emulator::index_register;
+  using Emulator::program_counter;
+  using Emulator::stack_pointer;
+};
+
+/**
+ * Runs body(iterations) with growing iteration counts until it takes at
+ * least min_time seconds
+ */
+Result measure(std::string const& name, double min_time, PerfCounters* counters,
+               std::function<void(uint64_t)> const& body) {
+  Result result(name);
+  uint64_t iterations = 1;
+  for (;;) {
+    if (counters != nullptr) {
+      counters->start();
+    }
+    Clock::time_point const start = Clock::now();
+    body(iterations);
+    double const seconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+    if (counters != nullptr) {
+      counters->stop();
+    }
+    if (seconds >= min_time || iterations >= (uint64_t(1) << 40)) {
+      result.iterations = iterations;
+      result.seconds = seconds;
+      readPerf(counters, result);
+      return result;
+    }
+    // Aim a bit past min_time, but never grow by more than 10x at once
+    double const factor = seconds > 0 ? 1.4 * min_time / seconds : 10.0;
+    iterations = static_cast<uint64_t>(iterations * std::min(10.0, factor)) + 1;
+  }
+}
+
+/**
+ * A handler benchmark. The opcode goes through handleOpcode(), as most
+ * handlers are inlined into it. setup runs once, fixup after every call to
+ * put back whatever the handler changed that would make the next call
+ * differ.
+ */
+struct HandlerBench {
+  char const*                            name;
+  halfword                               opcode;
+  std::function<void(BenchEmulator&)>    setup;
+  std::function<void(BenchEmulator&)>    fixup;
+};
+
+Result benchHandler(HandlerBench const& bench, double min_time,
+                    PerfCounters* counters) {
+  BenchEmulator emulator;
+  emulator.setSeed(bench_seed);
+  if (bench.setup) {
+    bench.setup(emulator);
+  }
+  bool ok = true;
+  Result result = measure(bench.name, min_time, counters,
+                          [&](uint64_t iterations) {
+    for (uint64_t i = 0; i < iterations; ++i) {
+      emulator.program_counter = Emulator::program_counter_start;
+      ok &= emulator.handleOpcode(bench.opcode);
+      if (bench.fixup) {
+        bench.fixup(emulator);
+      }
+    }
+  });
+  sink = sink + emulator.getRegister(0xF);
+  if (!ok) {
+    result.error = emulator.getError();
+  }
+  return result;
+}
+
+std::vector<std::string> listRoms(std::string const& dir) {
+  std::vector<std::string> files;
+  DIR* handle = opendir(dir.c_str());
+  if (handle == nullptr) {
+    return files;
+  }
+  while (dirent* entry = readdir(handle)) {
+    if (entry->d_name[0] != '.') {
+      files.push_back(entry->d_name);
+    }
+  }
+  closedir(handle);
+  std::sort(files.begin(), files.end());
+  return files;
+}
+
+/**
+ * Runs ticks ticks of a ROM, pressing and releasing keys in a fixed
+ * pseudo-random order so programs waiting for input keep going
+ */
+Result benchRom(std::string const& name, RomImage const& rom, uint64_t ticks,
+                PerfCounters* counters) {
+  Result result(name);
+  result.iterations = ticks;
+  Emulator emulator;
+  if (!emulator.loadRom(rom)) {
+    result.iterations = 0;
+    result.error = emulator.getError();
+    return result;
+  }
+  emulator.setSeed(bench_seed);
+
+  uint32_t keys = bench_seed;
+  if (counters != nullptr) {
+    counters->start();
+  }
+  Clock::time_point const start = Clock::now();
+  for (uint64_t i = 0; i < ticks; ++i) {
+    if ((i & 0xFF) == 0) {
+      keys = keys * 1103515245 + 12345;
+      emulator.setKeyState((keys >> 16) & 0xF, (keys >> 20) & 1);
+    }
+    if (!emulator.tick()) {
+      result.iterations = i + 1;
+      result.error = emulator.getError();
+      break;
+    }
+  }
+  result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+  if (counters != nullptr) {
+    counters->stop();
+  }
+  result.instructions = emulator.getInstructionCount();
+  readPerf(counters, result);
+  return result;
+}
+
+/**
+ * Runs the same ROM as lanes independent Emulators and as one
+ * LockstepEmulator with that many lanes, ticks lane steps in total each,
+ * with the same seed and keys per lane. The lockstep result reports its
+ * step rate as a multiple of the Emulators'.
+ */
+std::vector<Result> benchLockstep(std::string const& name,
+                                  std::string const& file, unsigned lanes,
+                                  uint64_t ticks, PerfCounters* counters) {
+  uint64_t const steps = ticks / lanes;
+  std::string const suffix = "/x" + std::to_string(lanes);
+  Result independent(name + "/emulators" + suffix);
+  Result lockstep_result(name + "/lockstep" + suffix);
+
+  std::vector<Emulator> emulators(lanes);
+  LockstepEmulator lockstep(lanes);
+  if (!lockstep.loadFileToRam(file)) {
+    lockstep_result.error = lockstep.getError(0);
+  }
+  for (unsigned lane = 0; lane < lanes; ++lane) {
+    if (!emulators[lane].loadFileToRam(file)) {
+      independent.error = emulators[lane].getError();
+    }
+    emulators[lane].setSeed(bench_seed + lane);
+    lockstep.setSeed(lane, bench_seed + lane);
+  }
+  if (!independent.error.empty() || !lockstep_result.error.empty()) {
+    return { independent, lockstep_result };
+  }
+
+  // Lanes press different keys, so they diverge as real instances would
+  auto const key = [](uint64_t step, unsigned lane, int& number, bool& on) {
+    uint32_t const k = static_cast<uint32_t>(step >> 8) * 1103515245
+                     + lane * 12345 + bench_seed;
+    number = (k >> 16) & 0xF;
+    on = (k >> 20) & 1;
+  };
+
+  if (counters != nullptr) {
+    counters->start();
+  }
+  Clock::time_point start = Clock::now();
+  for (uint64_t i = 0; i < steps && independent.error.empty(); ++i) {
+    for (unsigned lane = 0; lane < lanes; ++lane) {
+      if ((i & 0xFF) == 0) {
+        int number;
+        bool on;
+        key(i, lane, number, on);
+        emulators[lane].setKeyState(number, on);
+      }
+      if (!emulators[lane].tick()) {
+        independent.error = emulators[lane].getError();
+      }
+    }
+  }
+  independent.seconds =
+    std::chrono::duration<double>(Clock::now() - start).count();
+  if (counters != nullptr) {
+    counters->stop();
+  }
+  independent.iterations = steps * lanes;
+  readPerf(counters, independent);
+
+  if (counters != nullptr) {
+    counters->start();
+  }
+  start = Clock::now();
+  for (uint64_t i = 0; i < steps && lockstep_result.error.empty(); ++i) {
+    if ((i & 0xFF) == 0) {
+      for (unsigned lane = 0; lane < lanes; ++lane) {
+        int number;
+        bool on;
+        key(i, lane, number, on);
+        lockstep.setKeyState(lane, number, on);
+      }
+    }
+    if (!lockstep.tick()) {
+      lockstep_result.error = "Lane failed: "
+        + lockstep.getError(__builtin_ctz(lockstep.failedLanes()));
+    }
+  }
+  lockstep_result.seconds =
+    std::chrono::duration<double>(Clock::now() - start).count();
+  if (counters != nullptr) {
+    counters->stop();
+  }
+  lockstep_result.iterations = steps * lanes;
+  readPerf(counters, lockstep_result);
+
+  if (lockstep_result.seconds > 0) {
+    lockstep_result.step_rate_multiple =
+      independent.seconds / lockstep_result.seconds;
+  }
+  return { independent, lockstep_result };
+}
+
+std::string escape(std::string const& text) {
+  std::string escaped;
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      escaped += '\\';
+    }
+    if (static_cast<unsigned char>(c) >= 0x20) {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+void writeJson(std::ostream& out, Options const& options,
+               PerfCounters const* counters,
+               std::vector<Result> const& results) {
+  char date[32];
+  std::time_t const now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+  out << "{\n"
+      << "  \"context\": {\n"
+      << "    \"library\": \"chip8core\",\n"
+      << "    \"version\": \"" << CHIP8CORE_VERSION << "\",\n"
+      << "    \"build_type\": \"" << escape(CHIP8CORE_BUILD_TYPE) << "\",\n"
+      << "    \"cxx_flags\": \"" << escape(CHIP8CORE_CXX_FLAGS) << "\",\n"
+      << "    \"date\": \"" << date << "\",\n"
+      << "    \"opcode_counters\": "
+      << (Emulator::has_opcode_counters ? "true" : "false") << ",\n"
+      << "    \"seed\": " << bench_seed << ",\n"
+      << "    \"min_time\": " << options.min_time << ",\n"
+      << "    \"rom_ticks\": " << options.rom_ticks << ",\n"
+      << "    \"perf_counters\": [";
+  char const* separator = "";
+  for (int i = 0; counters != nullptr && i < PerfCounters::num_counters; ++i) {
+    PerfCounters::Counter const counter = static_cast<PerfCounters::Counter>(i);
+    if (counters->available(counter)) {
+      out << separator << "\"" << PerfCounters::name(counter) << "\"";
+      separator = ", ";
+    }
+  }
+  out << "]\n"
+      << "  },\n"
+      << "  \"benchmarks\": [";
+
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    Result const& result = results[i];
+    double const ns_per_op = result.iterations > 0
+      ? result.seconds * 1e9 / result.iterations : 0.0;
+    out << (i == 0 ? "\n" : ",\n")
+        << "    {\"name\": \"" << escape(result.name) << "\""
+        << ", \"iterations\": " << result.iterations
+        << ", \"seconds\": " << result.seconds
+        << ", \"ns_per_op\": " << ns_per_op;
+    if (result.instructions > 0) {
+      double const mips = result.seconds > 0
+        ? result.instructions / result.seconds / 1e6 : 0.0;
+      out << ", \"instructions\": " << result.instructions
+          << ", \"mips\": " << mips;
+    }
+    if (result.has_perf) {
+      bool const per_instruction = result.instructions > 0;
+      double const units = per_instruction
+        ? result.instructions : result.iterations;
+      for (int c = 0; c < PerfCounters::num_counters; ++c) {
+        PerfCounters::Counter const counter =
+          static_cast<PerfCounters::Counter>(c);
+        // Left out if it never got scheduled during this run
+        if (!result.perf_measured[c]) {
+          continue;
+        }
+        out << ", \"" << PerfCounters::name(counter) << "\": "
+            << result.perf[c]
+            << ", \"" << PerfCounters::name(counter)
+            << (per_instruction ? "_per_instruction" : "_per_op") << "\": "
+            << (units > 0 ? result.perf[c] / units : 0.0);
+      }
+    }
+    if (result.step_rate_multiple > 0) {
+      out << ", \"step_rate_multiple\": " << result.step_rate_multiple;
+    }
+    if (!result.error.empty()) {
+      out << ", \"error\": \"" << escape(result.error) << "\"";
+    }
+    out << "}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+void usage(char const* program) {
+  std::cerr << "Usage: " << program << " [--roms DIR] [--filter TEXT]"
+            << " [--min-time SECONDS] [--rom-ticks N] [--no-perf]\n";
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; ++i) {
+    std::string const arg = argv[i];
+    if (arg == "--no-perf") {
+      options.perf = false;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      usage(argv[0]);
+      return 1;
+    }
+    if (arg == "--roms") {
+      options.roms_dir = argv[++i];
+    } else if (arg == "--filter") {
+      options.filter = argv[++i];
+    } else if (arg == "--min-time") {
+      options.min_time = std::atof(argv[++i]);
+    } else if (arg == "--rom-ticks") {
+      options.rom_ticks = std::strtoull(argv[++i], nullptr, 10);
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  auto const selected = [&options](std::string const& name) {
+    return name.find(options.filter) != std::string::npos;
+  };
+  std::vector<Result> results;
+
+  PerfCounters perf_counters;
+  PerfCounters* const counters = options.perf ? &perf_counters : nullptr;
+
+  auto const resetStack = [](BenchEmulator& e) { e.stack_pointer = 0; };
+  auto const fontSprite = [](BenchEmulator& e) { e.index_register = 0; };
+  HandlerBench const handlers[] = {
+    { "handleOpcode0/CLS", 0x00E0, nullptr, nullptr },
+    { "handleOpcode1/JUMP", 0x1200, nullptr, nullptr },
+    { "handleOpcode2/CALL", 0x2200, nullptr, resetStack },
+    { "handleOpcode3/SKE", 0x3000, nullptr, nullptr },
+    { "handleOpcode4/SKNE", 0x4000, nullptr, nullptr },
+    { "handleOpcode5/SKRE", 0x5010, nullptr, nullptr },
+    { "handleOpcode6/LOAD", 0x6012, nullptr, nullptr },
+    { "handleOpcode7/ADD", 0x7001, nullptr, nullptr },
+    { "handleOpcode8/ADD", 0x8014, nullptr, nullptr },
+    { "handleOpcode8/SHR", 0x8016, nullptr, nullptr },
+    { "handleOpcode9/SKRNE", 0x9010, nullptr, nullptr },
+    { "handleOpcodeA/LOADI", 0xA300, nullptr, nullptr },
+    { "handleOpcodeB/JUMPI", 0xB200, nullptr, nullptr },
+    { "handleOpcodeC/RAND", 0xC0FF, nullptr, nullptr },
+    { "handleOpcodeD/DRAW", 0xD015,
+      [](BenchEmulator& e) { e.registers[0] = 8; e.registers[1] = 4; }, fontSprite },
+    { "handleOpcodeD/DRAW_unaligned", 0xD015,
+      [](BenchEmulator& e) { e.registers[0] = 11; e.registers[1] = 4; }, fontSprite },
+    { "handleOpcodeE/SKPR", 0xE09E, nullptr, nullptr },
+    { "handleOpcodeF/BCD", 0xF033,
+      [](BenchEmulator& e) { e.registers[0] = 123; e.index_register = 0x300; }, nullptr },
+    { "handleOpcodeF/STOR", 0xFF55,
+      [](BenchEmulator& e) { e.index_register = 0x300; },
+      [](BenchEmulator& e) { e.index_register = 0x300; } },
+  };
+  for (HandlerBench const& bench : handlers) {
+    if (selected(bench.name)) {
+      results.push_back(benchHandler(bench, options.min_time, counters));
+    }
+  }
+
+  std::vector<std::string> const roms = listRoms(options.roms_dir);
+  std::string const first_rom = roms.empty()
+    ? std::string() : options.roms_dir + "/" + roms.front();
+
+  if (selected("fetchOpcode") && !first_rom.empty()) {
+    BenchEmulator emulator;
+    emulator.loadFileToRam(first_rom);
+    results.push_back(measure("fetchOpcode", options.min_time, counters,
+      [&emulator](uint64_t iterations) {
+        uint64_t sum = 0;
+        for (uint64_t i = 0; i < iterations; ++i) {
+          emulator.program_counter = Emulator::program_counter_start;
+          sum += emulator.fetchOpcode();
+        }
+        sink = sink + sum;
+      }));
+  }
+
+  if (selected("loadFileToRam") && !first_rom.empty()) {
+    Emulator emulator;
+    bool ok = true;
+    results.push_back(measure("loadFileToRam", options.min_time, counters,
+      [&](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+          ok &= emulator.loadFileToRam(first_rom);
+        }
+      }));
+    if (!ok) {
+      results.back().error = emulator.getError();
+    }
+  }
+
+  if (selected("construct")) {
+    results.push_back(measure("construct", options.min_time, counters,
+      [](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+          Emulator emulator;
+          sink = sink + emulator.getProgramCounter();
+        }
+      }));
+  }
+
+  if (selected("resetState")) {
+    BenchEmulator emulator;
+    results.push_back(measure("resetState", options.min_time, counters,
+      [&emulator](uint64_t iterations) {
+        for (uint64_t i = 0; i < iterations; ++i) {
+          emulator.resetState();
+        }
+        sink = sink + emulator.getProgramCounter();
+      }));
+  }
+
+  for (std::string const& rom : roms) {
+    std::string const name = "rom/" + rom;
+    if (!selected(name)) {
+      continue;
+    }
+    RomImage image;
+    if (!image.mapFile(options.roms_dir + "/" + rom)) {
+      Result failed(name);
+      failed.error = image.getError();
+      results.push_back(failed);
+      continue;
+    }
+    results.push_back(benchRom(name, image, options.rom_ticks, counters));
+  }
+
+  // Many instances of one ROM, independently and in lockstep
+  for (unsigned lanes : { 8U, 32U }) {
+    std::string const name = "lockstep/" + (roms.empty() ? "" : roms.front());
+    if (!first_rom.empty() && selected(name)) {
+      for (Result const& result : benchLockstep(name, first_rom, lanes,
+                                                options.rom_ticks, counters)) {
+        results.push_back(result);
+      }
+    }
+  }
+
+  writeJson(std::cout, options, counters, results);
+
+  int status = 0;
+  for (Result const& result : results) {
+    if (!result.error.empty()) {
+      std::cerr << result.name << ": " << result.error << "\n";
+      status = 1;
+    }
+  }
+  return status;
+}
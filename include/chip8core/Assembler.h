@@ -0,0 +1,65 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Assembles the mnemonics understood by the compiler tool (see its --help)
+ * into a ROM in memory, ready for Emulator::loadRom().
+ *
+ * Tokens are separated by whitespace, numbers are hexadecimal and a
+ * command starting with ';' comments out the rest of its line. After an
+ * error, assembly continues on the next line so that every error in the
+ * source is reported.
+ */
+class Assembler {
+public:
+  struct Diagnostic {
+    enum Severity { Warning, Error };
+
+    Severity    severity;
+    unsigned    line;     // From 1
+    unsigned    column;   // From 1
+    std::string message;
+  };
+
+  explicit Assembler();
+  Assembler(Assembler const&) = default;
+  ~Assembler() = default;
+
+  Assembler& operator=(Assembler const&) = default;
+
+  /**
+   * Assembles size bytes of source into getOutput(), replacing any
+   * earlier output and diagnostics.
+   * Returns false if there were errors, and sets error message to the
+   * first of them (see getError())
+   */
+  bool assemble(char const* source, std::size_t size);
+  bool assemble(std::string const& source);
+
+  /**
+   * The assembled ROM. Empty if assemble() failed.
+   */
+  std::vector<uint8_t> const& getOutput() const;
+
+  /**
+   * Errors and warnings of the latest assemble(), in source order
+   */
+  std::vector<Diagnostic> const& getDiagnostics() const;
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+private:
+  std::vector<uint8_t>    output;
+  std::vector<Diagnostic> diagnostics;
+  std::string             error_msg;
+};
+
+#endif /* ASSEMBLER_H */
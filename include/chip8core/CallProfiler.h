@@ -0,0 +1,80 @@
+#ifndef CALL_PROFILER_H
+#define CALL_PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+#include "chip8core/Emulator.h"
+
+/**
+ * Call graph profiler, which attributes executed instructions to the
+ * subroutines (0x2NNN entry addresses) they ran in.
+ *
+ * Call observe() once before the first tick and after every tick, or use
+ * tick(). The profiler keeps a tree of call paths in step with the
+ * emulator's stack depth rather than decoding CALL and RET itself, so
+ * states loaded mid-call and programs that never return are followed as
+ * they are. Each observation costs a few comparisons.
+ * Code outside any subroutine is attributed to the entry point, 0x200.
+ */
+class CallProfiler {
+public:
+  struct Function {
+    halfword entry;
+    uint64_t calls;
+    uint64_t inclusive;  // Instructions in the subroutine and what it called
+    uint64_t exclusive;  // Instructions in the subroutine itself
+  };
+
+  explicit CallProfiler();
+  CallProfiler(CallProfiler const&) = default;
+  ~CallProfiler() = default;
+
+  CallProfiler& operator=(CallProfiler const&) = default;
+
+  /**
+   * Attribute the instructions executed since the last call, and follow
+   * any calls or returns
+   */
+  void observe(Emulator const& emulator);
+
+  /**
+   * Ticks emulator and observes it. Returns the result of Emulator::tick()
+   */
+  bool tick(Emulator& emulator);
+
+  void reset();
+
+  /**
+   * Totals per subroutine, most inclusive instructions first. Recursive
+   * calls are only counted once towards inclusive.
+   */
+  std::vector<Function> functions() const;
+
+  /**
+   * Writes one line per call path, e.g. "200;2a4;31c 1234", as used by
+   * flamegraph.pl and similar tools
+   */
+  void writeFolded(std::ostream& out) const;
+
+private:
+  struct Node {
+    halfword                 entry;
+    std::size_t              parent;
+    uint64_t                 calls;
+    uint64_t                 self;
+    std::vector<std::size_t> children;
+  };
+
+  std::size_t child(std::size_t parent, halfword entry);
+
+  std::vector<Node> nodes;
+  std::size_t       current;
+  unsigned          depth;
+  uint64_t          last_count;
+  bool              started;
+};
+
+#endif /* CALL_PROFILER_H */
@@ -0,0 +1,165 @@
+#ifndef CO_EMULATOR_H
+#define CO_EMULATOR_H
+
+#if __cplusplus < 202002L
+#error "chip8core/CoEmulator.h requires C++20. Build with 'cmake -Dcoroutines=ON'"
+#endif
+
+#include <atomic>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+
+#include "chip8core/Emulator.h"
+
+class CoExecutor;
+
+/**
+ * Return type of host coroutines. The coroutine does not start until it is
+ * handed to CoExecutor::spawn(), and cleans up after itself when it is done.
+ *
+ *   CoTask play(CoEmulator& emu) {
+ *     while (co_await emu.nextFrame()) { draw(emu.emulator()); }
+ *   }
+ */
+class CoTask {
+public:
+  struct promise_type {
+    CoTask get_return_object() {
+      return CoTask(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+
+  explicit CoTask(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+  CoTask(CoTask&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+  CoTask(CoTask const&) = delete;
+  ~CoTask() { if (handle) { handle.destroy(); } }
+
+  CoTask& operator=(CoTask const&) = delete;
+
+private:
+  friend class CoExecutor;
+  std::coroutine_handle<promise_type> handle;
+};
+
+/**
+ * An Emulator which host coroutines can co_await.
+ *
+ * Each awaitable resumes with true when the event happened, or false if
+ * the emulator failed first (see getError()). Only one coroutine may wait
+ * on a CoEmulator at a time. The emulator is ticked by a CoExecutor, on
+ * whichever of its threads picks it up, and the coroutine is resumed there.
+ *
+ * While the emulator waits for a key press, nextFrame() and sound() can not
+ * happen, so ROMs using 0xFX0A should be driven with keyWait().
+ */
+class CoEmulator {
+public:
+  explicit CoEmulator(CoExecutor& executor, Emulator const& emulator);
+  CoEmulator(CoEmulator const&) = delete;
+  ~CoEmulator() = default;
+
+  CoEmulator& operator=(CoEmulator const&) = delete;
+
+  class Awaiter;
+
+  /**
+   * Resumes after the screen has changed (see Emulator::onGraphics)
+   */
+  Awaiter nextFrame();
+
+  /**
+   * Resumes when the emulator waits for a key press (0xFX0A).
+   * Call emulator().setKeyState() to let it continue.
+   */
+  Awaiter keyWait();
+
+  /**
+   * Resumes when the sound timer runs out (see Emulator::onSound)
+   */
+  Awaiter sound();
+
+  Emulator& emulator();
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+private:
+  friend class CoExecutor;
+
+  enum class Waiting { Nothing, Frame, Key, Sound };
+
+  bool eventHappened() const;
+
+  CoExecutor&             executor;
+  Emulator                emu;
+  Waiting                 waiting;
+  bool                    event_fired;
+  bool                    failed;
+  std::coroutine_handle<> handle;
+  std::string             error_msg;
+};
+
+class CoEmulator::Awaiter {
+public:
+  Awaiter(CoEmulator& emulator, Waiting what) : emulator(emulator), what(what) {}
+
+  bool await_ready() const {
+    return what == Waiting::Key && emulator.emu.isAwaitingKeypress();
+  }
+  void await_suspend(std::coroutine_handle<> handle);
+  bool await_resume() const { return !emulator.failed; }
+
+private:
+  CoEmulator& emulator;
+  Waiting     what;
+};
+
+/**
+ * Multiplexes the CoEmulators which have a waiting coroutine over a few
+ * threads. Each emulator is ticked for at most ticks_per_slice ticks before
+ * the next one gets its turn.
+ */
+class CoExecutor {
+public:
+  explicit CoExecutor(unsigned ticks_per_slice = 64);
+  CoExecutor(CoExecutor const&) = delete;
+  ~CoExecutor() = default;
+
+  CoExecutor& operator=(CoExecutor const&) = delete;
+
+  /**
+   * Starts the coroutine on the calling thread. It runs until its first
+   * co_await.
+   */
+  void spawn(CoTask task);
+
+  /**
+   * Runs until no coroutine is waiting any more.
+   * num_threads == 0 uses one thread per hardware thread.
+   */
+  void run(unsigned num_threads = 1);
+
+private:
+  friend class CoEmulator::Awaiter;
+
+  void schedule(CoEmulator& emulator);
+  void work();
+  bool runSlice(CoEmulator& emulator);
+
+  unsigned                ticks_per_slice;
+  std::mutex              lock;
+  std::deque<CoEmulator*> ready;
+  std::atomic<std::size_t> waiting;
+};
+
+#endif /* CO_EMULATOR_H */
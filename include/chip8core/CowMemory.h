@@ -0,0 +1,139 @@
+#ifndef COW_MEMORY_H
+#define COW_MEMORY_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
+/**
+ * Fixed size memory made of pages which are shared copy-on-write.
+ *
+ * Copying a CowMemory only copies the page table. A page is copied the
+ * first time it is written to while another copy still uses it, so copies
+ * only cost the pages they actually change.
+ *
+ * Reads should use get() (or the const overloads), since the non-const
+ * at() assumes a write and unshares the page.
+ */
+template <std::size_t Size, std::size_t PageSize>
+class CowMemory {
+  static_assert(Size % PageSize == 0, "CowMemory size must be whole pages");
+
+public:
+  std::size_t static constexpr num_pages = Size / PageSize;
+
+  class const_iterator {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = uint8_t;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = uint8_t const*;
+    using reference         = uint8_t;
+
+    const_iterator(CowMemory const& memory, std::size_t pos) : memory(&memory), pos(pos) {}
+    uint8_t operator*() const { return memory->get(pos); }
+    const_iterator& operator++() { ++pos; return *this; }
+    bool operator==(const_iterator const& other) const { return pos == other.pos; }
+    bool operator!=(const_iterator const& other) const { return pos != other.pos; }
+
+  private:
+    CowMemory const* memory;
+    std::size_t      pos;
+  };
+
+  CowMemory() : pages() { pages.fill(zeroPage()); }
+
+  std::size_t size() const { return Size; }
+
+  /**
+   * Bounds checked access, like std::vector::at()
+   */
+  uint8_t get(std::size_t address) const {
+    check(address);
+    return pages[address / PageSize]->data[address % PageSize];
+  }
+  uint8_t at(std::size_t address) const { return get(address); }
+  uint8_t& at(std::size_t address) {
+    check(address);
+    return writablePage(address / PageSize)[address % PageSize];
+  }
+
+  /**
+   * Copy length bytes starting at address out of or into memory
+   */
+  void read(std::size_t address, uint8_t* out, std::size_t length) const {
+    if (length > 0) { check(address + length - 1); }
+    while (length > 0) {
+      std::size_t const offset = address % PageSize;
+      std::size_t const chunk = std::min(length, PageSize - offset);
+      memcpy(out, pages[address / PageSize]->data + offset, chunk);
+      address += chunk; out += chunk; length -= chunk;
+    }
+  }
+  void write(std::size_t address, uint8_t const* in, std::size_t length) {
+    if (length > 0) { check(address + length - 1); }
+    while (length > 0) {
+      std::size_t const offset = address % PageSize;
+      std::size_t const chunk = std::min(length, PageSize - offset);
+      memcpy(writablePage(address / PageSize) + offset, in, chunk);
+      address += chunk; in += chunk; length -= chunk;
+    }
+  }
+
+  /**
+   * Returns true if page is shared with another copy
+   */
+  bool isShared(std::size_t page) const {
+    return pages.at(page).use_count() > 1;
+  }
+
+  const_iterator begin() const { return const_iterator(*this, 0); }
+  const_iterator end() const { return const_iterator(*this, Size); }
+
+  bool operator==(CowMemory const& other) const {
+    for (std::size_t i = 0; i < num_pages; ++i) {
+      if (pages[i] != other.pages[i]
+          && memcmp(pages[i]->data, other.pages[i]->data, PageSize) != 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+  bool operator!=(CowMemory const& other) const { return !(*this == other); }
+
+private:
+  struct Page {
+    uint8_t data[PageSize];
+  };
+
+  static std::shared_ptr<Page> const& zeroPage() {
+    static std::shared_ptr<Page> const zero = std::make_shared<Page>(Page());
+    return zero;
+  }
+
+  static void check(std::size_t address) {
+    if (address >= Size) {
+      throw std::out_of_range("CowMemory: address out of range");
+    }
+  }
+
+  uint8_t* writablePage(std::size_t page) {
+    std::shared_ptr<Page>& current = pages[page];
+    if (current.use_count() > 1) {
+      current = std::make_shared<Page>(*current);
+    }
+    return current->data;
+  }
+
+  std::array<std::shared_ptr<Page>, num_pages> pages;
+};
+
+template <std::size_t Size, std::size_t PageSize>
+std::size_t constexpr CowMemory<Size, PageSize>::num_pages;
+
+#endif /* COW_MEMORY_H */
@@ -0,0 +1,160 @@
+#ifndef DEBUG_SERVER_H
+#define DEBUG_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chip8core/Emulator.h"
+
+/**
+ * Debugger protocol over a Unix domain socket. Little-endian.
+ *
+ * Request:  command u8, a u16, b u16, payload length u16, payload
+ * Response: status u8 (0 ok, 1 error), length u16, payload or error message
+ */
+enum class DebugCommand : uint8_t {
+  Pause = 1,         // Stop ticking the emulator
+  Continue,          // Tick again, resuming from any breakpoint or watchpoint
+  Step,              // Pause, then execute max(a, 1) instructions
+  Status,            // Returns a DebugStatus
+  SetRegister,       // Register a (0-15 V, 16 I, 17 PC) = b
+  ReadRam,           // Returns b bytes of RAM from address a
+  WriteRam,          // Copies the payload into RAM at address a
+  ReadScreen,        // Returns b bytes of screen from offset a
+  WriteScreen,       // Copies the payload into the screen at offset a
+  SetBreakpoint,     // Breakpoint at address a, on if b is not 0
+  SetWatchpoint,     // Watch b bytes from a, payload is WatchType u8, on u8
+  ClearDebugPoints,  // Remove all breakpoints and watchpoints
+};
+
+/**
+ * Payload of the response to DebugCommand::Status
+ */
+struct DebugStatus {
+  bool       paused;
+  StopReason stop_reason;
+  halfword   stop_address;
+  halfword   program_counter;
+  halfword   index_register;
+  byte       stack_depth;
+  byte       registers[Emulator::num_registers];
+  uint64_t   instruction_count;
+
+  std::size_t static constexpr size = 17 + Emulator::num_registers;
+  void write(byte* out) const;
+  static DebugStatus read(byte const* in);
+};
+
+/**
+ * Lets a debugger attach to a running emulator over a Unix domain socket,
+ * one client at a time (see DebugClient and the chip8debug tool).
+ *
+ * A background thread talks to the client, and hands each request to the
+ * thread ticking the emulator, which serves it in tick(). Without a pending
+ * request, tick() costs the emulation thread a single atomic load on top
+ * of Emulator::tick().
+ */
+class DebugServer {
+public:
+  explicit DebugServer();
+  DebugServer(DebugServer const&) = delete;
+  ~DebugServer();
+
+  DebugServer& operator=(DebugServer const&) = delete;
+
+  /**
+   * Listen on socket path, replacing any stale socket file there. Fails if
+   * something other than a socket, or a socket another server is listening
+   * on, is at path.
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool open(std::string const& path);
+  void close();
+
+  /**
+   * Serves pending requests, then ticks emulator unless paused.
+   * Returns the result of Emulator::tick(), or true while paused
+   */
+  bool tick(Emulator& emulator);
+
+  /**
+   * Returns true while a client has paused the emulator
+   */
+  bool isPaused() const;
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+private:
+  struct Request {
+    DebugCommand      command;
+    uint16_t          a;
+    uint16_t          b;
+    std::vector<byte> payload;
+  };
+
+  void serve(Emulator& emulator);
+  bool handle(Emulator& emulator, Request const& request,
+              std::vector<byte>& response);
+  void run();
+  void talk(int client);
+
+  int                     listen_fd;
+  std::string             socket_path;
+  std::thread             thread;
+  std::atomic<bool>       running;
+  std::atomic<bool>       pending;
+  std::mutex              mutex;
+  std::condition_variable served;
+  Request                 request;
+  std::vector<byte>       response;
+  bool                    response_ok;
+  bool                    done;
+  bool                    paused;
+  std::string             error_msg;
+};
+
+/**
+ * Client side of the debugger protocol
+ */
+class DebugClient {
+public:
+  explicit DebugClient();
+  DebugClient(DebugClient const&) = delete;
+  ~DebugClient();
+
+  DebugClient& operator=(DebugClient const&) = delete;
+
+  /**
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool connect(std::string const& path);
+  void disconnect();
+
+  /**
+   * Sends a request and waits for the response payload.
+   * Returns false on error, and sets error message (see getError()),
+   * which is the server's message if it refused the request.
+   */
+  bool request(DebugCommand command, uint16_t a, uint16_t b,
+               std::vector<byte> const& payload, std::vector<byte>& response);
+  bool request(DebugCommand command, uint16_t a, uint16_t b);
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+private:
+  int         fd;
+  std::string error_msg;
+};
+
+#endif /* DEBUG_SERVER_H */
@@ -0,0 +1,12 @@
+#ifndef DISASSEMBLER_H
+#define DISASSEMBLER_H
+
+#include <ostream>
+
+/**
+ * Writes one line to out describing opcode at address line, e.g.
+ * "L200: 6a02 - reg[a] = 02". Formatting flags of out are left as they were.
+ */
+void describeOpcode(std::ostream& out, int line, int opcode);
+
+#endif /* DISASSEMBLER_H */
@@ -1,20 +1,35 @@
 #ifndef EMULATOR_H
 #define EMULATOR_H
 
+#include <array>
+#include <bitset>
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 #include <string>
 #include <stdexcept>
 #include <functional>
 
+#include "chip8core/CowMemory.h"
+#include "chip8core/OpcodeCounters.h"
+#include "chip8core/RomAnalysis.h"
+#include "chip8core/RomImage.h"
+#include "chip8core/RuntimeCounters.h"
+#include "chip8core/StopReason.h"
+
+class WriteProvenance;
+
 using byte       = uint8_t;
 using halfword   = uint16_t;
 using screen_row = uint8_t;
 
 class Emulator {
+  friend class LockstepEmulator;
+
 public:
   explicit Emulator();
   explicit Emulator(Emulator const&) = default;
+  Emulator(Emulator&&) = default;
   ~Emulator() = default;
 
   Emulator& operator=(Emulator const&) = default;
@@ -26,12 +41,61 @@ public:
    */
   std::string const& getError() const;
 
+  /**
+   * Returns a copy of the emulator state without callbacks, for exploring
+   * several futures from one state. RAM is shared copy-on-write between
+   * the two, so a fork only costs the RAM pages it (or the parent) later
+   * writes to.
+   */
+  Emulator fork() const;
+
   /**
    * Get a pointer to the graphics data
    * TODO: Add more info
    */
   byte const* getGraphicsData() const;
 
+  /**
+   * Returns the address of the next instruction to be executed
+   */
+  halfword getProgramCounter() const;
+
+  /**
+   * Returns the value of register V[index], or of the index register I
+   */
+  byte getRegister(unsigned index) const;
+  halfword getIndexRegister() const;
+
+  /**
+   * Returns the number of return addresses on the stack
+   */
+  unsigned getStackDepth() const;
+
+  /**
+   * Copies length bytes of RAM starting at address into out.
+   * Throws std::out_of_range if the range is outside of RAM.
+   */
+  void readRam(halfword address, byte* out, std::size_t length) const;
+
+  /**
+   * Overwrite machine state, for debuggers. Writes are not seen by
+   * watchpoints. writeGraphicsData() copies into the screen at offset (see
+   * getGraphicsData()) and calls onGraphics.
+   * Throw std::out_of_range if the register or range does not exist.
+   */
+  void setRegister(unsigned index, byte value);
+  void setIndexRegister(halfword value);
+  void setProgramCounter(halfword address);
+  void writeRam(halfword address, byte const* in, std::size_t length);
+  void writeGraphicsData(std::size_t offset, byte const* in,
+                         std::size_t length);
+
+  /**
+   * Returns the number of instructions executed since construction or the
+   * latest resetState(). Ticks spent waiting for a key press do not count.
+   */
+  uint64_t getInstructionCount() const;
+
   /**
    * Set the key to either pressed or unpressed
    * key_number must be between 0 and Emulator::num_keys
@@ -39,6 +103,11 @@ public:
    */
   void setKeyState(int key_number, bool on);
 
+  /**
+   * Returns true if the CPU is halted waiting for a key press (0xFX0A)
+   */
+  bool isAwaitingKeypress() const;
+
   /**
    * If a function is set here, it will execute when the CPU wants sound
    */
@@ -63,6 +132,119 @@ public:
    */
   bool loadFileToRam(std::string const& file);
 
+  /**
+   * Loads size bytes of data into RAM, like loadFileToRam() without
+   * touching the filesystem.
+   * Returns true on success.
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool loadRom(byte const* data, std::size_t size);
+  bool loadRom(RomImage const& rom);
+
+  /**
+   * Returns the shared analysis of the ROM loaded with loadRom() or
+   * loadFileToRam(), or null if none was loaded. Instructions are fetched
+   * from it for as long as the program does not write to their RAM page.
+   */
+  std::shared_ptr<RomAnalysis const> const& getRomAnalysis() const;
+
+  /**
+   * Seed the random number generator used by 0xCXNN.
+   * Every instance has its own generator, so emulators running on different
+   * threads never share state. The default seed is taken from time().
+   * The seed is kept by resetState() and loadRom(), which restart the
+   * generator from it, so every run of a seeded ROM draws the same numbers.
+   */
+  void setSeed(uint32_t seed);
+
+  /**
+   * Writes a snapshot of the emulator state into buffer, which needs to be
+   * at least state_size bytes. Nothing is allocated.
+   * Returns the number of bytes written, or 0 if buffer is too small.
+   * The snapshot covers RAM, screen, registers, timers, stack, keys,
+   * key press wait and the random number generator, but not callbacks or
+   * the error message.
+   */
+  std::size_t saveState(byte* buffer, std::size_t size) const;
+  std::vector<byte> saveState() const;
+
+  /**
+   * Restores a snapshot made by saveState().
+   * Returns true on success.
+   * Returns false on error, and sets error message (see getError()).
+   * On error, the emulator state is left untouched.
+   */
+  bool loadState(byte const* buffer, std::size_t size);
+
+  /**
+   * Returns the counters since construction, the latest ROM load or
+   * resetRuntimeCounters(). Unlike getOpcodeCounters(), these are always
+   * kept.
+   */
+  RuntimeCounters const& getRuntimeCounters() const;
+  void resetRuntimeCounters();
+
+  /**
+   * Returns why the latest tick() failed, or FaultType::None
+   */
+  FaultType getFault() const;
+
+  /**
+   * Stop before executing the instruction at address.
+   * Throws std::out_of_range if address is outside of RAM.
+   */
+  void setBreakpoint(halfword address, bool on);
+
+  /**
+   * Stop after an instruction reads or writes (see WatchType) any of the
+   * length bytes from address. Data accesses by 0xDXYN, 0xFX33, 0xFX55 and
+   * 0xFX65 are watched, instruction fetches are not.
+   * Throws std::out_of_range if the range is outside of RAM.
+   */
+  void setWatchpoint(halfword address, std::size_t length, WatchType type,
+                     bool on);
+
+  /**
+   * Removes all breakpoints and watchpoints. They are otherwise kept when
+   * a ROM is loaded.
+   */
+  void clearDebugPoints();
+
+  /**
+   * Record every RAM write (0xFX33, 0xFX55) and screen change (0x00E0,
+   * 0xDXYN) into provenance, which must outlive the emulator, or stop
+   * recording with nullptr. Loading a ROM clears it. Forks and other
+   * copies do not record.
+   */
+  void setWriteProvenance(WriteProvenance* provenance);
+
+  /**
+   * Returns why execution stopped, or StopReason::None. While stopped,
+   * tick() does nothing and returns true. Until a breakpoint or watchpoint
+   * is set, the only cost to tick() is checking a flag.
+   */
+  StopReason getStopReason() const;
+
+  /**
+   * Returns the breakpoint address, or the watched address which was
+   * accessed, of the latest stop
+   */
+  halfword getStopAddress() const;
+
+  /**
+   * Continue after a stop. A breakpoint at the program counter is stepped
+   * over once.
+   */
+  void resume();
+
+  /**
+   * Returns a snapshot of the execution counts since construction, the
+   * latest ROM load or resetOpcodeCounters(). They are all zero unless
+   * has_opcode_counters is true.
+   */
+  OpcodeCounters getOpcodeCounters() const;
+  void resetOpcodeCounters();
+
   unsigned static constexpr ram_size = 4096;
   unsigned static constexpr num_registers = 16;
   unsigned static constexpr screen_columns = 64 / 8;
@@ -70,8 +252,21 @@ public:
   unsigned static constexpr screen_bytes = screen_rows * screen_columns;
   unsigned static constexpr stack_size = 16;
   unsigned static constexpr num_keys = 16;
+  unsigned static constexpr ram_page_size = 256;
   halfword static constexpr program_counter_start = 0x200;
 
+#ifdef CHIP8CORE_OPCODE_COUNTERS
+  bool static constexpr has_opcode_counters = true;
+#else
+  bool static constexpr has_opcode_counters = false;
+#endif
+
+  // Save state layout: magic, version, RAM, screen, registers, stack, keys,
+  // I, PC, stack pointer, timers, key press wait, RNG. Little-endian.
+  uint16_t static constexpr state_version = 1;
+  std::size_t static constexpr state_size = 8 + ram_size + screen_bytes
+    + num_registers + stack_size * 2 + num_keys + 14;
+
 protected:
   halfword fetchOpcode();
 
@@ -107,26 +302,84 @@ protected:
   byte& vf_register();
 
   void increment_pc();
+  uint32_t next_random();
 
 
   void resetState();
   void addFontDataToRam();
+  bool fault(FaultType type, std::string const& message);
+  void notifyGraphics();
+  void notifySound();
+  void markRamModified(std::size_t address, std::size_t length);
+
+  // Breakpoints and watchpoints, shared copy-on-write between forks
+  struct DebugPoints {
+    std::bitset<ram_size> breakpoints;
+    std::bitset<ram_size> read_watchpoints;
+    std::bitset<ram_size> write_watchpoints;
+  };
+  DebugPoints& writableDebugPoints();
+  void updateDebugActive();
+  bool checkBreakpoint();
+  void checkWatchpoints(halfword address, std::size_t length, bool write);
+  void recordRamWrite(halfword address, std::size_t length);
+  void recordScreenChange(std::size_t offset);
+  void updateModifiedPages();
+
+  // The provenance index, which copies do not inherit: a copy is another
+  // timeline, and its writes would break the order of the index chains
+  class ProvenanceLink {
+  public:
+    ProvenanceLink(WriteProvenance* provenance) : provenance(provenance) {}
+    ProvenanceLink(ProvenanceLink const&) : provenance(nullptr) {}
+
+    ProvenanceLink& operator=(ProvenanceLink const&) {
+      provenance = nullptr;
+      return *this;
+    }
+    ProvenanceLink& operator=(WriteProvenance* other) {
+      provenance = other;
+      return *this;
+    }
+
+    operator WriteProvenance*() const { return provenance; }
+    WriteProvenance* operator->() const { return provenance; }
+
+  private:
+    WriteProvenance* provenance;
+  };
+
+  CowMemory<ram_size, ram_page_size>      ram;
+  std::array<screen_row, screen_bytes>    screen;
+  std::array<byte, num_registers>         registers;
+  halfword                                index_register;
+  halfword                                program_counter;
+  byte                                    sound_timer;
+  byte                                    delay_timer;
+  std::array<halfword, stack_size>        stack;
+  byte                                    stack_pointer;
+  std::array<byte, num_keys>              keys_state;
 
-  std::vector<byte>       ram;
-  std::vector<screen_row> screen;
-  std::vector<byte>       registers;
-  halfword                index_register;
-  halfword                program_counter;
-  byte                    sound_timer;
-  byte                    delay_timer;
-  std::vector<halfword>   stack;
-  byte                    stack_pointer;
-  std::vector<byte>       keys_state;
-
-  std::string             error_msg;
-  bool                    tick_lock;
-  bool                    awaiting_keypress;
-  unsigned                awaiting_keypress_register;
+  std::string                             error_msg;
+  bool                                    tick_lock;
+  bool                                    awaiting_keypress;
+  unsigned                                awaiting_keypress_register;
+  uint32_t                                rng_state;
+  uint32_t                                rng_seed;
+  uint64_t                                instruction_count;
+  FaultType                               fault_type;
+  RuntimeCounters                         runtime_counters;
+  std::shared_ptr<RomAnalysis const>      rom_analysis;
+  std::bitset<ram_size / ram_page_size>   modified_pages;
+  std::shared_ptr<DebugPoints>            debug_points;
+  ProvenanceLink                          write_provenance;
+  bool                                    debug_active;
+  bool                                    step_over_breakpoint;
+  StopReason                              stop_reason;
+  halfword                                stop_address;
+#ifdef CHIP8CORE_OPCODE_COUNTERS
+  OpcodeCounters                          opcode_counters;
+#endif
 };
 
 #endif /* EMULATOR_H */
@@ -0,0 +1,151 @@
+#ifndef EMULATOR_FARM_H
+#define EMULATOR_FARM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "chip8core/Emulator.h"
+
+/**
+ * Runs many headless Emulator instances on a pool of worker threads.
+ *
+ * Work is split into frame sized quanta (ticks_per_frame ticks). Each worker
+ * owns a queue of instances, and steals from the other workers when its own
+ * queue runs dry. An instance is run until one of its stop conditions is met.
+ *
+ * Callbacks (onGraphics/onSound) of added instances are called from the
+ * worker threads.
+ */
+class EmulatorFarm {
+public:
+  enum class StopReason {
+    None,           // Still running
+    FrameLimit,     // StopCondition::max_frames was reached
+    ProgramCounter, // StopCondition::program_counter was reached
+    ScreenHash,     // StopCondition::screen_hash was seen at end of a frame
+    Error           // tick() failed, see Result::error
+  };
+
+  /**
+   * When to stop an instance. Conditions not enabled are ignored, so an
+   * instance without any conditions runs until it fails.
+   */
+  struct StopCondition {
+    StopCondition();
+
+    uint64_t max_frames;          // 0 means no limit
+    bool     stop_at_pc;
+    halfword program_counter;     // Checked after every tick
+    bool     stop_at_screen_hash;
+    uint64_t screen_hash;         // Checked after every frame, see screenHash()
+  };
+
+  struct Result {
+    Result();
+
+    StopReason  reason;
+    uint64_t    frames;
+    uint64_t    ticks;
+    halfword    program_counter;
+    uint64_t    screen_hash;
+    std::string error;
+  };
+
+  struct Summary {
+    Summary();
+
+    std::size_t instances;
+    std::size_t frame_limit;
+    std::size_t program_counter;
+    std::size_t screen_hash;
+    std::size_t errors;
+    uint64_t    frames;
+    uint64_t    ticks;
+    double      seconds;
+  };
+
+  /**
+   * threads == 0 uses one thread per hardware thread.
+   * If pin is set, worker N is pinned to core N (Linux only).
+   */
+  explicit EmulatorFarm(unsigned threads = 0,
+                        unsigned frame_ticks = 10,
+                        bool pin = true);
+  EmulatorFarm(EmulatorFarm const&) = delete;
+  ~EmulatorFarm() = default;
+
+  EmulatorFarm& operator=(EmulatorFarm const&) = delete;
+
+  /**
+   * Adds a copy of emulator to the farm. Returns its id, used for result().
+   */
+  std::size_t add(Emulator const& emulator, StopCondition const& stop);
+
+  /**
+   * Loads file into a fresh emulator and adds it to the farm.
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool addRom(std::string const& file, StopCondition const& stop,
+              std::size_t* id = nullptr);
+
+  /**
+   * Loads rom into a fresh emulator and adds it to the farm. Use this to
+   * start many instances of one game without reading the file every time.
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool addRom(RomImage const& rom, StopCondition const& stop,
+              std::size_t* id = nullptr);
+
+  /**
+   * Runs all instances which have not yet stopped, and blocks until they have.
+   */
+  Summary run();
+
+  Result const& result(std::size_t id) const;
+  Emulator const& emulator(std::size_t id) const;
+  std::size_t size() const;
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+  /**
+   * FNV-1a hash of the screen, as used by StopCondition::screen_hash
+   */
+  static uint64_t screenHash(Emulator const& emulator);
+
+private:
+  struct Instance {
+    Instance(Emulator const& source, StopCondition const& stop_condition);
+
+    Emulator      emulator;
+    StopCondition stop;
+    Result        result;
+  };
+
+  struct WorkQueue {
+    std::mutex              lock;
+    std::deque<std::size_t> jobs;
+  };
+
+  void work(unsigned worker);
+  bool popJob(unsigned worker, std::size_t& job);
+  bool runQuantum(Instance& instance);
+
+  unsigned                                num_threads;
+  unsigned                                ticks_per_frame;
+  bool                                    pin_threads;
+  std::vector<Instance>                   instances;
+  std::vector<std::unique_ptr<WorkQueue>> queues;
+  std::atomic<std::size_t>                remaining;
+  std::string                             error_msg;
+};
+
+#endif /* EMULATOR_FARM_H */
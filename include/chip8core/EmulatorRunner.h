@@ -0,0 +1,98 @@
+#ifndef EMULATOR_RUNNER_H
+#define EMULATOR_RUNNER_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#include "chip8core/Emulator.h"
+#include "chip8core/SpscQueue.h"
+
+/**
+ * Runs an Emulator on a dedicated thread.
+ *
+ * Key events go in through one lock-free queue, and frames, sound and
+ * faults come out through another. Neither side blocks the other: if the
+ * host does not poll often enough, events are dropped (see droppedEvents()).
+ *
+ * pushKey() must only be called from one thread, and pollEvent() must only
+ * be called from one thread (which may be the same one).
+ */
+class EmulatorRunner {
+public:
+  struct Event {
+    enum class Type {
+      Frame, // Screen changed during the last frame, see screen
+      Sound, // Sound timer ran out
+      Fault  // tick() failed, see error. The runner has stopped.
+    };
+
+    Type type;
+    byte screen[Emulator::screen_bytes];
+    char error[64];
+  };
+
+  /**
+   * The runner runs its own copy of emulator. Its callbacks are replaced.
+   * ticks_per_second is spread out over frames_per_second frames.
+   */
+  explicit EmulatorRunner(Emulator const& emulator,
+                          unsigned ticks_per_second = 600,
+                          unsigned frames_per_second = 60);
+  EmulatorRunner(EmulatorRunner const&) = delete;
+  ~EmulatorRunner();
+
+  EmulatorRunner& operator=(EmulatorRunner const&) = delete;
+
+  /**
+   * Starts or stops the emulation thread.
+   * stop() blocks until the thread has finished its current frame.
+   */
+  void start();
+  void stop();
+
+  /**
+   * Returns true if the emulation thread is running
+   */
+  bool isRunning() const;
+
+  /**
+   * Queue a key event, see Emulator::setKeyState.
+   * Returns false if key_number is invalid or the queue is full.
+   */
+  bool pushKey(int key_number, bool on);
+
+  /**
+   * Take the next event, if any. Returns false if there are none.
+   */
+  bool pollEvent(Event& event);
+
+  /**
+   * Number of events dropped because the event queue was full
+   */
+  uint64_t droppedEvents() const;
+
+private:
+  struct KeyEvent {
+    byte key_number;
+    bool on;
+  };
+
+  void run();
+  void publish(Event const& event);
+  void publishFault(char const* error);
+
+  Emulator                      emulator;
+  unsigned                      ticks_per_frame;
+  unsigned                      frames_per_second;
+  bool                          graphics_changed;
+  Event                         scratch_event;
+
+  SpscQueue<KeyEvent, 256>      key_queue;
+  SpscQueue<Event, 64>          event_queue;
+  std::atomic<bool>             running;
+  std::atomic<uint64_t>         dropped_events;
+  std::thread                   thread;
+};
+
+#endif /* EMULATOR_RUNNER_H */
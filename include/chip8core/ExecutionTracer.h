@@ -0,0 +1,131 @@
+#ifndef EXECUTION_TRACER_H
+#define EXECUTION_TRACER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "chip8core/Emulator.h"
+
+/**
+ * One executed instruction. The written register is the one the opcode
+ * stores its result in (VX, or VF for 0xDXYN), with its new value.
+ */
+struct TraceRecord {
+  halfword program_counter;
+  halfword opcode;
+  halfword index_register;
+  bool     has_register;
+  byte     register_number;
+  byte     register_value;
+  bool     fault;  // The instruction failed, see Trace::fault
+
+  /**
+   * Records are stored as one 64-bit word each
+   */
+  uint64_t pack() const;
+  static TraceRecord unpack(uint64_t packed);
+};
+
+/**
+ * A trace as spilled to disk by ExecutionTracer, oldest record first
+ */
+struct Trace {
+  Trace();
+
+  /**
+   * Save to or load from file.
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool save(std::string const& file);
+  bool load(std::string const& file);
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+  std::vector<TraceRecord> records;
+  std::string              fault;  // Error message of the fault, if any
+  std::string              error_msg;
+};
+
+/**
+ * Records the most recent instructions of an emulator into a ring, for
+ * post-mortem debugging.
+ *
+ * Only the thread ticking the emulator writes to the ring, and it never
+ * waits: every record is a single atomic word. Other threads may take a
+ * snapshot() at any time. spill() writes a snapshot to disk on a
+ * background thread, and happens automatically on a fault if a fault file
+ * is set.
+ */
+class ExecutionTracer {
+public:
+  /**
+   * capacity is rounded up to a power of two
+   */
+  explicit ExecutionTracer(std::size_t capacity = 1 << 16);
+  ExecutionTracer(ExecutionTracer const&) = delete;
+  ~ExecutionTracer();
+
+  ExecutionTracer& operator=(ExecutionTracer const&) = delete;
+
+  /**
+   * Ticks emulator and records the instruction it executed, if any.
+   * Returns the result of Emulator::tick()
+   */
+  bool tick(Emulator& emulator);
+
+  /**
+   * Spill to file whenever tick() fails. Empty turns it off.
+   */
+  void setFaultFile(std::string const& file);
+
+  /**
+   * Copy of the records currently in the ring, oldest first. That is at
+   * most capacity - 1 records, as the oldest slot may be in the middle of
+   * being overwritten.
+   */
+  std::vector<TraceRecord> snapshot() const;
+
+  /**
+   * Number of records written since construction
+   */
+  uint64_t recorded() const;
+
+  /**
+   * Start writing a snapshot to file in the background, after any earlier
+   * spill has finished
+   */
+  void spill(std::string const& file);
+
+  /**
+   * Wait for the latest spill to finish.
+   * Returns false if it failed, and sets error message (see getError())
+   */
+  bool waitForSpill();
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+private:
+  void append(TraceRecord const& record);
+  void spill(std::string const& file, std::string const& fault);
+
+  std::vector<std::atomic<uint64_t>> ring;
+  uint64_t                           mask;
+  std::atomic<uint64_t>              head;
+  std::string                        fault_file;
+  std::thread                        spill_thread;
+  Trace                              spill_trace;
+  bool                               spill_ok;
+  std::string                        error_msg;
+};
+
+#endif /* EXECUTION_TRACER_H */
@@ -0,0 +1,134 @@
+#ifndef INPUT_LOG_H
+#define INPUT_LOG_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "chip8core/Emulator.h"
+
+/**
+ * Everything needed to replay a session bit-exactly: the starting state
+ * (including the seed), every key event stamped with the number of
+ * instructions executed before it, and state hashes to verify against.
+ */
+struct InputLog {
+  struct KeyEvent {
+    uint64_t instruction;
+    byte     key_number;
+    bool     on;
+  };
+
+  struct FrameHash {
+    uint64_t instruction;
+    uint64_t events_before; // Key events recorded before this hash
+    uint64_t hash;
+  };
+
+  InputLog();
+
+  /**
+   * Save to or load from file.
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool save(std::string const& file);
+  bool load(std::string const& file);
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+  uint32_t               seed;
+  std::vector<byte>      start_state;
+  std::vector<KeyEvent>  key_events;
+  std::vector<FrameHash> frame_hashes;
+  std::string            error_msg;
+};
+
+/**
+ * Records an emulator session into an InputLog.
+ * Key events need to go through the recorder instead of straight to the
+ * emulator; ticking is done on the emulator as usual.
+ */
+class InputRecorder {
+public:
+  /**
+   * Seeds emulator with seed and starts recording from its current state
+   */
+  explicit InputRecorder(Emulator& emulator, uint32_t seed);
+  InputRecorder(InputRecorder const&) = delete;
+  ~InputRecorder() = default;
+
+  InputRecorder& operator=(InputRecorder const&) = delete;
+
+  /**
+   * Records the key event, and passes it on to Emulator::setKeyState
+   */
+  void setKeyState(int key_number, bool on);
+
+  /**
+   * Records a hash of the current state, which replays are verified against.
+   * Typically called once per frame.
+   */
+  void markFrame();
+
+  InputLog const& log() const;
+
+  /**
+   * Hash of the emulator state, as used by markFrame()
+   */
+  static uint64_t stateHash(Emulator const& emulator, byte* scratch);
+
+private:
+  Emulator&         emulator;
+  uint64_t          start_instruction;
+  InputLog          input_log;
+  std::vector<byte> scratch;
+};
+
+/**
+ * Replays an InputLog on an emulator, which should have the same ROM
+ * loaded as the recorded one.
+ */
+class InputReplayer {
+public:
+  /**
+   * Restores the starting state of log into emulator
+   */
+  explicit InputReplayer(Emulator& emulator, InputLog const& log);
+  InputReplayer(InputReplayer const&) = delete;
+  ~InputReplayer() = default;
+
+  InputReplayer& operator=(InputReplayer const&) = delete;
+
+  /**
+   * Feeds due key events to the emulator, ticks it, and verifies due hashes.
+   * Returns false on error or if the replay diverged from the recording,
+   * and sets error message (see getError())
+   */
+  bool tick();
+
+  /**
+   * Returns true when all events and hashes have been replayed
+   */
+  bool finished() const;
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+private:
+  bool replayDue();
+
+  Emulator&         emulator;
+  InputLog const&   input_log;
+  uint64_t          start_instruction;
+  std::size_t       next_event;
+  std::size_t       next_hash;
+  std::vector<byte> scratch;
+  std::string       error_msg;
+};
+
+#endif /* INPUT_LOG_H */
@@ -0,0 +1,135 @@
+#ifndef LOCKSTEP_EMULATOR_H
+#define LOCKSTEP_EMULATOR_H
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "chip8core/Emulator.h"
+
+/**
+ * Runs up to max_lanes instances of the same ROM side by side.
+ *
+ * State is kept as structure-of-arrays: each register, timer, the index
+ * register and program counter is an array with one entry per lane. Every
+ * tick, lanes which are about to execute the same opcode at the same address
+ * are grouped, and the group is executed at once over a lane mask.
+ *
+ * When lanes diverge too much (more than divergence_limit groups in one
+ * tick), grouping is given up for the rest of that tick and the remaining
+ * lanes are executed one at a time.
+ *
+ * Each lane behaves exactly like an Emulator ticked the same number of times.
+ *
+ * The gain over independent Emulators comes from fetching, decoding and
+ * dispatching once per group. The per-lane loops are plain scalar loops.
+ * bench_chip8core reports the measured multiple (lockstep/ROM/lockstep/xN).
+ */
+class LockstepEmulator {
+public:
+  unsigned static constexpr max_lanes = 32;
+
+  /**
+   * num_lanes must be between 1 and max_lanes.
+   * divergence_limit == 0 means num_lanes / 4 (at least 1).
+   */
+  explicit LockstepEmulator(unsigned num_lanes, unsigned divergence_limit = 0);
+  LockstepEmulator(LockstepEmulator const&) = default;
+  ~LockstepEmulator() = default;
+
+  LockstepEmulator& operator=(LockstepEmulator const&) = default;
+
+  unsigned lanes() const;
+
+  /**
+   * Copy the state of an emulator into a lane, or out of a lane.
+   * Callbacks are not copied.
+   */
+  void setLane(unsigned lane, Emulator const& emulator);
+  void getLane(unsigned lane, Emulator& emulator) const;
+
+  /**
+   * Loads file with filename into RAM of all lanes.
+   * Returns true on success.
+   * Returns false on error, and sets error message of every lane
+   * (see getError()).
+   * The lanes all get the same seed, see setSeed()
+   */
+  bool loadFileToRam(std::string const& file);
+
+  /**
+   * Same as Emulator::setKeyState and Emulator::setSeed, but for one lane
+   */
+  void setKeyState(unsigned lane, int key_number, bool on);
+  void setSeed(unsigned lane, uint32_t seed);
+
+  /**
+   * Tell all lanes to process one clock cycle
+   * Returns false if any lane failed. Use failedLanes() to see which,
+   * and getError() for the error message of a lane.
+   */
+  bool tick();
+
+  /**
+   * Bitmask of the lanes which failed during the last tick
+   */
+  uint32_t failedLanes() const;
+
+  std::string const& getError(unsigned lane) const;
+  byte const* getGraphicsData(unsigned lane) const;
+  halfword getProgramCounter(unsigned lane) const;
+
+  /**
+   * Number of groups executed since construction. Divided by the number of
+   * ticks, this tells how well the lanes stay in lockstep.
+   */
+  uint64_t getGroupCount() const;
+
+  /**
+   * Called with the lane number, see Emulator::onSound and Emulator::onGraphics
+   */
+  std::function<void(unsigned)> onSound;
+  std::function<void(unsigned)> onGraphics;
+
+private:
+  void executeGroup(uint32_t mask, halfword opcode);
+  void executeOpcode0(uint32_t mask, halfword opcode);
+  void executeOpcode8(uint32_t mask, halfword opcode);
+  void executeOpcodeD(uint32_t mask, halfword opcode);
+  void executeOpcodeE(uint32_t mask, halfword opcode);
+  void executeOpcodeF(uint32_t mask, halfword opcode);
+  void notImplemented(uint32_t mask, halfword opcode);
+  void fail(unsigned lane, std::string const& error);
+
+  byte& reg(unsigned lane, unsigned number);
+  byte& ramAt(unsigned lane, unsigned address);
+  byte& keyAt(unsigned lane, unsigned key);
+
+  unsigned                 num_lanes;
+  unsigned                 divergence_limit;
+
+  // Per lane arrays. Multi-dimensional ones are stored as [index][lane],
+  // except for RAM and screen which are stored as [lane][index].
+  std::vector<byte>        ram;
+  std::vector<screen_row>  screen;
+  std::vector<byte>        registers;
+  std::vector<halfword>    index_register;
+  std::vector<halfword>    program_counter;
+  std::vector<byte>        sound_timer;
+  std::vector<byte>        delay_timer;
+  std::vector<halfword>    stack;
+  std::vector<byte>        stack_pointer;
+  std::vector<byte>        keys_state;
+  std::vector<byte>        awaiting_keypress;
+  std::vector<byte>        awaiting_keypress_register;
+  std::vector<uint32_t>    rng_state;
+  std::vector<std::string> error_msg;
+
+  // Scratch space for tick()
+  std::vector<halfword>    opcodes;
+  uint32_t                 failed_lanes;
+  uint64_t                 group_count;
+};
+
+#endif /* LOCKSTEP_EMULATOR_H */
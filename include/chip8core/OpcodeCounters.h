@@ -0,0 +1,31 @@
+#ifndef OPCODE_COUNTERS_H
+#define OPCODE_COUNTERS_H
+
+#include <cstdint>
+
+/**
+ * Execution counts collected by Emulator when the library is built with
+ * CHIP8CORE_OPCODE_COUNTERS defined ('cmake -Dopcode_counters=ON').
+ * Without it, the counting code is not compiled in at all.
+ */
+struct OpcodeCounters {
+  OpcodeCounters() :
+    classes(),
+    arithmetic(),
+    keys(),
+    misc(),
+    skips(0),
+    sprite_rows(0),
+    collisions(0)
+    {}
+
+  uint64_t classes[16];     // Every opcode, by its first nibble
+  uint64_t arithmetic[16];  // 0x8XY?, by its last nibble
+  uint64_t keys[256];       // 0xEX??, by its last byte
+  uint64_t misc[256];       // 0xFX??, by its last byte
+  uint64_t skips;           // Instructions skipped by 3XNN, 4XNN, 5XY0, 9XY0, EX9E and EXA1
+  uint64_t sprite_rows;     // Rows drawn by DXYN
+  uint64_t collisions;      // DXYN which set VF
+};
+
+#endif /* OPCODE_COUNTERS_H */
@@ -0,0 +1,74 @@
+#ifndef PC_PROFILER_H
+#define PC_PROFILER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+#include "chip8core/Emulator.h"
+
+/**
+ * Sampling profiler, which records the program counter every interval
+ * instructions into a histogram over the whole address space.
+ *
+ * Call sample() after every tick of the emulator, or use tick(). Sampling
+ * is driven by Emulator::getInstructionCount(), so calls which are not due
+ * cost one comparison. A call records at most one sample, so calling it
+ * less often than every interval instructions loses samples.
+ */
+class PcProfiler {
+public:
+  explicit PcProfiler(unsigned interval = 1);
+  PcProfiler(PcProfiler const&) = default;
+  ~PcProfiler() = default;
+
+  PcProfiler& operator=(PcProfiler const&) = default;
+
+  /**
+   * Record the program counter of emulator if a sample is due
+   */
+  void sample(Emulator const& emulator) {
+    // Wraps around when the instruction count went back, e.g. after
+    // Emulator::loadRom(), so sampling restarts instead of stalling
+    if (emulator.getInstructionCount() - last_sample >= sample_interval) {
+      record(emulator);
+    }
+  }
+
+  /**
+   * Ticks emulator and samples it. Returns the result of Emulator::tick()
+   */
+  bool tick(Emulator& emulator);
+
+  /**
+   * Add the samples of other, e.g. from other instances of the same ROM
+   */
+  void merge(PcProfiler const& other);
+
+  void reset();
+
+  /**
+   * Number of samples at address, and in total
+   */
+  uint64_t count(halfword address) const;
+  uint64_t total() const;
+
+  /**
+   * Writes the max_lines most sampled addresses to out, hottest first,
+   * with their share of the samples and the disassembly of the opcode
+   * currently in the RAM of emulator at that address.
+   */
+  void report(std::ostream& out, Emulator const& emulator,
+              std::size_t max_lines = 20) const;
+
+private:
+  void record(Emulator const& emulator);
+
+  unsigned                                  sample_interval;
+  uint64_t                                  last_sample;
+  uint64_t                                  total_samples;
+  std::array<uint64_t, Emulator::ram_size>  histogram;
+};
+
+#endif /* PC_PROFILER_H */
@@ -0,0 +1,97 @@
+#ifndef REWIND_BUFFER_H
+#define REWIND_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "chip8core/Emulator.h"
+
+/**
+ * Keeps the most recent emulator states, for rewinding.
+ *
+ * Every keyframe_interval captures, a keyframe is stored. Other captures are
+ * stored as the XOR against their keyframe, run-length encoded, which is
+ * small since most of RAM and the screen does not change between frames.
+ * All of it lives in one ring, and the oldest frames are dropped to make
+ * room. Restoring decodes at most two records.
+ *
+ * memory_limit covers both the ring and the index of stored frames: an
+ * eighth of it caps the number of frames, and the rest is the ring.
+ */
+class RewindBuffer {
+public:
+  explicit RewindBuffer(std::size_t memory_limit = 1024 * 1024,
+                        unsigned keyframe_interval = 60);
+  RewindBuffer(RewindBuffer const&) = default;
+  ~RewindBuffer() = default;
+
+  RewindBuffer& operator=(RewindBuffer const&) = default;
+
+  /**
+   * Store the current state of emulator as the newest frame
+   */
+  void capture(Emulator const& emulator);
+
+  /**
+   * Restore the frame frames_back captures ago, where 0 is the newest.
+   * Returns true on success.
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool restore(std::size_t frames_back, Emulator& emulator);
+
+  /**
+   * Drop everything newer than frames_back, e.g. after restoring it
+   */
+  void discardNewest(std::size_t frames_back);
+
+  /**
+   * Number of frames which can be restored
+   */
+  std::size_t size() const;
+
+  /**
+   * Bytes of the ring which hold frames, plus their index
+   */
+  std::size_t memoryUsed() const;
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+private:
+  struct Frame {
+    std::size_t offset;
+    std::size_t length;
+    uint64_t    sequence;
+    uint64_t    keyframe;   // Sequence number of the keyframe it is based on
+  };
+
+  std::size_t encode(byte const* state, byte const* base);
+  void decode(Frame const& frame, byte* state) const;
+  bool place(std::size_t length);
+  void dropOldest();
+
+  std::size_t       max_frames;
+  std::size_t       capacity;
+  unsigned          keyframe_interval;
+  std::vector<byte> ring;
+  std::size_t       write_pos;
+  std::size_t       used;
+  std::deque<Frame> frames;
+  uint64_t          next_sequence;
+  uint64_t          current_keyframe;
+  bool              have_keyframe;
+  unsigned          since_keyframe;
+
+  // Scratch space, so capturing and restoring does not allocate
+  std::vector<byte> state;
+  std::vector<byte> keyframe_state;
+  std::vector<byte> encoded;
+  std::string       error_msg;
+};
+
+#endif /* REWIND_BUFFER_H */
@@ -0,0 +1,103 @@
+#ifndef ROM_ANALYSIS_H
+#define ROM_ANALYSIS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * Static analysis of a ROM: the opcode at every address, which bytes are
+ * reachable code, jump and call targets, and basic block boundaries.
+ *
+ * Code is found by following every path from the entry point, so code
+ * only reached through 0xBNNN is treated as data. Everything not marked as
+ * code is data.
+ *
+ * An analysis never changes once made, and get() shares one per distinct
+ * ROM between all threads, so only the first instance of a ROM pays for
+ * it. Emulators attach to the analysis of the ROM they load, and ignore it
+ * for any RAM page the program has since written to.
+ */
+class RomAnalysis {
+public:
+  explicit RomAnalysis(uint8_t const* data, std::size_t size);
+  RomAnalysis(RomAnalysis const&) = delete;
+  ~RomAnalysis() = default;
+
+  RomAnalysis& operator=(RomAnalysis const&) = delete;
+
+  /**
+   * Returns the analysis of data from the process-wide cache, analysing it
+   * first if this is the first time it is seen. Thread-safe.
+   * Entries are dropped when nothing uses them any more.
+   */
+  static std::shared_ptr<RomAnalysis const> get(uint8_t const* data, std::size_t size);
+
+  /**
+   * Number of analyses currently held by the cache
+   */
+  static std::size_t cacheSize();
+
+  /**
+   * 64-bit FNV-1a hash of data, which the cache is keyed by
+   */
+  static uint64_t contentHash(uint8_t const* data, std::size_t size);
+
+  uint64_t hash() const;
+  std::size_t size() const;
+  uint8_t const* data() const;
+
+  /**
+   * Returns true if both bytes of an opcode at address are part of the ROM
+   */
+  bool contains(uint16_t address) const;
+
+  /**
+   * Opcode at address, which must be contained in the ROM
+   */
+  uint16_t opcode(uint16_t address) const;
+
+  /**
+   * Returns true if address is the first byte of a reachable instruction,
+   * or any byte of one for isCode()
+   */
+  bool isInstruction(uint16_t address) const;
+  bool isCode(uint16_t address) const;
+
+  /**
+   * Returns true if address is the target of a 0x1NNN jump or 0x2NNN call
+   */
+  bool isJumpTarget(uint16_t address) const;
+
+  /**
+   * Returns true if a basic block starts at address
+   */
+  bool isBlockStart(uint16_t address) const;
+
+  /**
+   * Start addresses of all basic blocks, in ascending order
+   */
+  std::vector<uint16_t> const& blockStarts() const;
+
+  uint16_t static constexpr start_address = 0x200;
+
+private:
+  enum Flag : uint8_t {
+    Instruction = 1 << 0,
+    Code        = 1 << 1,
+    JumpTarget  = 1 << 2,
+    BlockStart  = 1 << 3,
+  };
+
+  bool hasFlag(uint16_t address, Flag flag) const;
+  void analyse();
+
+  std::vector<uint8_t>  rom;
+  uint64_t              content_hash;
+  std::vector<uint16_t> opcodes;
+  std::vector<uint8_t>  flags;
+  std::vector<uint16_t> block_starts;
+};
+
+#endif /* ROM_ANALYSIS_H */
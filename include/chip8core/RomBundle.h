@@ -0,0 +1,121 @@
+#ifndef ROM_BUNDLE_H
+#define ROM_BUNDLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "chip8core/RomImage.h"
+
+/**
+ * Many ROMs in one file, which is opened with a single mmap. The index at
+ * the start of the file is sorted by name, and every ROM can be passed
+ * straight from the mapping to Emulator::loadRom().
+ *
+ * File layout, little-endian:
+ *   header: "C8RB", version u16, 0 u16, entry count u32, 0 u32
+ *   index:  per entry name offset u32, name length u32, FNV-1a hash u64,
+ *           data offset u32, data size u32, quirks u32, 0 u32
+ *   names and ROM data, at the offsets given in the index
+ *
+ * Quirks are a bit set which is stored for the application, the emulator
+ * itself does not interpret them.
+ */
+class RomBundle {
+public:
+  struct Entry {
+    std::string    name;
+    uint64_t       hash;
+    uint32_t       quirks;
+    uint8_t const* data;
+    std::size_t    size;
+  };
+
+  explicit RomBundle();
+  RomBundle(RomBundle const&) = delete;
+  ~RomBundle() = default;
+
+  RomBundle& operator=(RomBundle const&) = delete;
+
+  /**
+   * Map file and check its index.
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool open(std::string const& file);
+
+  /**
+   * Number of ROMs in the bundle
+   */
+  std::size_t size() const;
+
+  /**
+   * ROM number index, in name order. The data points into the mapping, and
+   * is valid until the bundle is opened again or destroyed.
+   */
+  Entry entry(std::size_t index) const;
+
+  /**
+   * Returns the index of the ROM called name, or npos if there is none
+   */
+  std::size_t find(std::string const& name) const;
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+  std::size_t static constexpr npos = static_cast<std::size_t>(-1);
+  uint16_t static constexpr version = 1;
+  std::size_t static constexpr header_size = 16;
+  std::size_t static constexpr index_entry_size = 32;
+
+private:
+  uint8_t const* indexEntry(std::size_t index) const;
+  std::string name(std::size_t index) const;
+
+  RomImage    image;
+  std::size_t num_entries;
+  std::string error_msg;
+};
+
+/**
+ * Collects ROMs and writes them out as a RomBundle
+ */
+class RomBundleWriter {
+public:
+  explicit RomBundleWriter();
+  RomBundleWriter(RomBundleWriter const&) = default;
+  ~RomBundleWriter() = default;
+
+  RomBundleWriter& operator=(RomBundleWriter const&) = default;
+
+  /**
+   * Add a ROM. A ROM added under a name which is already used replaces it.
+   */
+  void add(std::string const& name, uint8_t const* data, std::size_t size,
+           uint32_t quirks = 0);
+
+  /**
+   * Write the bundle to file.
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool write(std::string const& file);
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+private:
+  struct Rom {
+    std::string          name;
+    uint32_t             quirks;
+    std::vector<uint8_t> data;
+  };
+
+  std::vector<Rom> roms;
+  std::string      error_msg;
+};
+
+#endif /* ROM_BUNDLE_H */
@@ -0,0 +1,55 @@
+#ifndef ROM_IMAGE_H
+#define ROM_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * Read-only ROM contents, either memory mapped from a file or held in
+ * memory, which any number of emulators can load from with
+ * Emulator::loadRom(). Share one image between threads through
+ * SharedRomImage; it is never changed after loading.
+ */
+class RomImage {
+public:
+  explicit RomImage();
+  RomImage(RomImage const&) = delete;
+  ~RomImage();
+
+  RomImage& operator=(RomImage const&) = delete;
+
+  /**
+   * Memory map file, replacing the current contents.
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool mapFile(std::string const& file);
+
+  /**
+   * Copy size bytes of data, replacing the current contents
+   */
+  void assign(uint8_t const* data, std::size_t size);
+
+  uint8_t const* data() const;
+  std::size_t size() const;
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+private:
+  void release();
+
+  uint8_t const*       contents;
+  std::size_t          length;
+  void*                mapped;
+  std::vector<uint8_t> buffer;
+  std::string          error_msg;
+};
+
+using SharedRomImage = std::shared_ptr<RomImage const>;
+
+#endif /* ROM_IMAGE_H */
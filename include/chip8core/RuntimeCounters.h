@@ -0,0 +1,53 @@
+#ifndef RUNTIME_COUNTERS_H
+#define RUNTIME_COUNTERS_H
+
+#include <cstdint>
+
+/**
+ * Why Emulator::tick() failed
+ */
+enum class FaultType : uint8_t {
+  None,
+  StackOverflow,
+  StackUnderflow,
+  ProgramCounterOutOfBounds,
+  UnknownOpcode,
+};
+unsigned constexpr num_fault_types = 5;
+
+/**
+ * Counters every Emulator keeps about itself, for hosts to poll and export.
+ * They are plain integers owned by the emulator, so read them from the
+ * thread which ticks it.
+ */
+struct RuntimeCounters {
+  RuntimeCounters() :
+    ticks(0),
+    instructions(0),
+    idle_ticks(0),
+    frames(0),
+    draws(0),
+    collisions(0),
+    timer_underflows(0),
+    graphics_callbacks(0),
+    sound_callbacks(0),
+    graphics_callback_ns(0),
+    sound_callback_ns(0),
+    faults()
+    {}
+
+  uint64_t ticks;                  // Calls to tick()
+  uint64_t instructions;           // Instructions retired, without faults
+  uint64_t idle_ticks;             // Ticks skipped waiting for a key press
+  uint64_t frames;                 // Screen updates, by 00E0 or DXYN
+  uint64_t draws;                  // DXYN executed
+  uint64_t collisions;             // DXYN which set VF
+  uint64_t timer_underflows;       // Delay or sound timer reaching zero
+  uint64_t graphics_callbacks;     // Calls to onGraphics
+  uint64_t sound_callbacks;        // Calls to onSound
+  uint64_t graphics_callback_ns;   // Time spent inside onGraphics
+  uint64_t sound_callback_ns;      // Time spent inside onSound
+  uint64_t faults[num_fault_types];  // Failed ticks, indexed by FaultType
+};
+
+#endif /* RUNTIME_COUNTERS_H */
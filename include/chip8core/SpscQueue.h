@@ -0,0 +1,61 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Lock-free, fixed size queue for exactly one producer thread and
+ * one consumer thread. Neither side ever blocks: tryPush() fails when the
+ * queue is full and tryPop() fails when it is empty.
+ * Capacity must be a power of two.
+ */
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "SpscQueue capacity must be a power of two");
+
+public:
+  SpscQueue() : head(0), head_padding(), tail(0), tail_padding(), slots() {}
+  SpscQueue(SpscQueue const&) = delete;
+  ~SpscQueue() = default;
+
+  SpscQueue& operator=(SpscQueue const&) = delete;
+
+  /**
+   * Producer side. Returns false if the queue is full.
+   */
+  bool tryPush(T const& value) {
+    std::size_t const current_tail = tail.load(std::memory_order_relaxed);
+    if (current_tail - head.load(std::memory_order_acquire) == Capacity) {
+      return false;
+    }
+    slots[current_tail & (Capacity - 1)] = value;
+    tail.store(current_tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Consumer side. Returns false if the queue is empty.
+   */
+  bool tryPop(T& value) {
+    std::size_t const current_head = head.load(std::memory_order_relaxed);
+    if (current_head == tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = slots[current_head & (Capacity - 1)];
+    head.store(current_head + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  // Padded to separate cache lines, so producer and consumer don't fight.
+  // Padding rather than alignas, since C++11 new ignores over-alignment.
+  std::atomic<std::size_t> head;
+  char                     head_padding[64 - sizeof(std::atomic<std::size_t>)];
+  std::atomic<std::size_t> tail;
+  char                     tail_padding[64 - sizeof(std::atomic<std::size_t>)];
+  T                        slots[Capacity];
+};
+
+#endif /* SPSC_QUEUE_H */
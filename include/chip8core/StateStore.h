@@ -0,0 +1,91 @@
+#ifndef STATE_STORE_H
+#define STATE_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "chip8core/Emulator.h"
+
+/**
+ * A file of save states which is memory mapped instead of read.
+ *
+ * Records have a fixed size, so record n lives at a known offset and the
+ * file is its own index. Each record holds a caller chosen key, the state
+ * as written by Emulator::saveState() and a CRC-32 of both. Restoring
+ * checks the CRC and hands the mapped bytes straight to loadState(), so
+ * only the pages which are restored are ever read from disk.
+ *
+ * File layout, little-endian:
+ *   header: "C8SB", version u16, 0 u16, state size u32, record size u32,
+ *           record count u64, zero padding up to header_size
+ *   record: key u64, state, CRC-32 u32, zero padding up to record_size
+ */
+class StateStore {
+public:
+  explicit StateStore();
+  StateStore(StateStore const&) = delete;
+  ~StateStore();
+
+  StateStore& operator=(StateStore const&) = delete;
+
+  /**
+   * Open file, closing any file opened before.
+   * If writable is true, the file is created if it does not exist and
+   * append() may be used.
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool open(std::string const& file, bool writable = false);
+  void close();
+
+  /**
+   * Append the current state of emulator as a new record
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool append(Emulator const& emulator, uint64_t key = 0);
+
+  /**
+   * Restore record index into emulator, after checking its CRC.
+   * Returns false on error, and sets error message (see getError())
+   */
+  bool restore(std::size_t index, Emulator& emulator);
+
+  /**
+   * Returns true if the CRC of record index matches its contents
+   */
+  bool verify(std::size_t index) const;
+
+  /**
+   * Key given to append() for record index
+   */
+  uint64_t key(std::size_t index) const;
+
+  /**
+   * Number of records
+   */
+  std::size_t size() const;
+
+  /**
+   * Returns most recent error message
+   */
+  std::string const& getError() const;
+
+  uint16_t static constexpr version = 1;
+  std::size_t static constexpr header_size = 64;
+  std::size_t static constexpr record_size =
+    (8 + Emulator::state_size + 4 + 7) / 8 * 8;
+
+private:
+  bool map(std::size_t length);
+  void unmap();
+  byte const* record(std::size_t index) const;
+
+  int         fd;
+  bool        writable;
+  byte*       mapped;
+  std::size_t mapped_length;
+  std::size_t num_records;
+  std::string error_msg;
+};
+
+#endif /* STATE_STORE_H */
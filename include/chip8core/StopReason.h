@@ -0,0 +1,25 @@
+#ifndef STOP_REASON_H
+#define STOP_REASON_H
+
+#include <cstdint>
+
+/**
+ * Why Emulator stopped executing, see Emulator::getStopReason()
+ */
+enum class StopReason : uint8_t {
+  None,
+  Breakpoint,
+  ReadWatchpoint,
+  WriteWatchpoint,
+};
+
+/**
+ * Which accesses a watchpoint catches
+ */
+enum WatchType : unsigned {
+  WatchRead      = 1,
+  WatchWrite     = 2,
+  WatchReadWrite = WatchRead | WatchWrite,
+};
+
+#endif /* STOP_REASON_H */
@@ -0,0 +1,69 @@
+#ifndef WRITE_PROVENANCE_H
+#define WRITE_PROVENANCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Index of which instruction last wrote each RAM address and changed each
+ * screen byte, for answering "who wrote A before instruction N" without
+ * re-running a session. Attach it with Emulator::setWriteProvenance().
+ *
+ * Every write is one 8-byte record in the chain of its address, in
+ * execution order, so queries are a binary search. Instructions are
+ * numbered like Emulator::getInstructionCount(): the first one is 0. Only
+ * their lower 48 bits are kept.
+ * To ask about a frame, note getInstructionCount() when the frame starts.
+ */
+class WriteProvenance {
+public:
+  struct Write {
+    uint16_t program_counter;  // Address of the writing instruction
+    uint64_t instruction;      // Number of the writing instruction
+  };
+
+  explicit WriteProvenance();
+  WriteProvenance(WriteProvenance const&) = default;
+  ~WriteProvenance() = default;
+
+  WriteProvenance& operator=(WriteProvenance const&) = default;
+
+  /**
+   * Record a write of length bytes of RAM from address, or a change of
+   * screen byte offset (see Emulator::getGraphicsData())
+   */
+  void recordRam(std::size_t address, std::size_t length,
+                 uint16_t program_counter, uint64_t instruction);
+  void recordScreen(std::size_t offset,
+                    uint16_t program_counter, uint64_t instruction);
+
+  /**
+   * Finds the latest write by an instruction numbered below before.
+   * Returns false if there is none.
+   */
+  bool lastRamWrite(std::size_t address, uint64_t before, Write& write) const;
+  bool lastScreenChange(std::size_t offset, uint64_t before,
+                        Write& write) const;
+
+  /**
+   * Number of writes recorded
+   */
+  std::size_t size() const;
+
+  void clear();
+
+private:
+  // Each record is the instruction number << 16 | program counter
+  using Chain = std::vector<uint64_t>;
+
+  static void record(Chain& chain, uint16_t program_counter,
+                     uint64_t instruction);
+  static bool find(Chain const& chain, uint64_t before, Write& write);
+
+  std::vector<Chain> ram;
+  std::vector<Chain> screen;
+  std::size_t        records;
+};
+
+#endif /* WRITE_PROVENANCE_H */
@@ -0,0 +1,348 @@
+#include <string>
+#include <vector>
+
+#include "chip8core/Assembler.h"
+
+namespace {
+
+// A whitespace separated token, pointing into the source
+struct Token {
+  char const* data;
+  std::size_t size;
+  unsigned    line;    // From 1
+  unsigned    column;  // From 1
+
+  std::string str() const { return std::string(data, size); }
+};
+
+// Splits the source into tokens
+class Lexer {
+public:
+  Lexer(char const* begin, char const* end) :
+    pos(begin), end(end), line_start(begin), line(1) {}
+
+  // Returns false at end of input
+  bool next(Token& token) {
+    for (; pos != end && isSpace(*pos); ++pos) {
+      if (*pos == '\n') {
+        line_start = pos + 1;
+        ++line;
+      }
+    }
+    if (pos == end) { return false; }
+
+    token.data = pos;
+    token.line = line;
+    token.column = pos - line_start + 1;
+    while (pos != end && !isSpace(*pos)) { ++pos; }
+    token.size = pos - token.data;
+    return true;
+  }
+
+  void skipLine() {
+    while (pos != end && *pos != '\n') { ++pos; }
+  }
+
+private:
+  static bool isSpace(char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+  }
+
+  char const* pos;
+  char const* end;
+  char const* line_start;
+  unsigned    line;
+};
+
+enum operands {
+  NONE,    // OP
+  R,       // OP rX
+  RR,      // OP rX rY
+  N,       // OP N
+  NNN,     // OP NNN
+  RNN,     // OP rX NN
+  RRN,     // OP rX rY N
+  RV,      // OP rX NN or OP rX rY
+  NNNN     // DATA NNNN
+};
+
+struct Mnemonic {
+  char const* name;
+  operands    kind;
+  uint8_t     lop;   // High byte, or high byte with NN
+  uint8_t     rop;   // Low byte, or high byte with rY
+  uint8_t     rop2;  // Low nibble with rY
+};
+
+// Mnemonics are at most four characters, so they pack into a perfect key
+constexpr uint32_t key(char const* name, unsigned i = 0, uint32_t k = 0) {
+  return i == 4 ? k
+       : name[0] == '\0' ? key(name, i + 1, k << 8)
+       : key(name + 1, i + 1, (k << 8) | static_cast<uint8_t>(name[0]));
+}
+
+Mnemonic const* lookup(Token const& token) {
+  if (token.size == 0 || token.size > 4) {
+    return nullptr;
+  }
+  uint32_t k = 0;
+  for (std::size_t i = 0; i < 4; ++i) {
+    k = (k << 8) | (i < token.size ? static_cast<uint8_t>(token.data[i]) : 0);
+  }
+
+#define MNEMONIC(name, ...) \
+  case key(name): { \
+    static Mnemonic const m = { name, __VA_ARGS__ }; \
+    return token.size == sizeof(name) - 1 ? &m : nullptr; \
+  }
+
+  switch (k) {
+    MNEMONIC("CLS",  NONE, 0x00, 0xE0, 0x00)
+    MNEMONIC("RET",  NONE, 0x00, 0xEE, 0x00)
+    MNEMONIC("JMP",  NNN,  0x10, 0x00, 0x00)
+    MNEMONIC("CALL", NNN,  0x20, 0x00, 0x00)
+    MNEMONIC("IFN",  RV,   0x30, 0x50, 0x00)
+    MNEMONIC("IF",   RV,   0x40, 0x90, 0x00)
+    MNEMONIC("SET",  RV,   0x60, 0x80, 0x00)
+    MNEMONIC("ADD",  RV,   0x70, 0x80, 0x04)
+    MNEMONIC("OR",   RR,   0x80, 0x01, 0x00)
+    MNEMONIC("AND",  RR,   0x80, 0x02, 0x00)
+    MNEMONIC("XOR",  RR,   0x80, 0x03, 0x00)
+    MNEMONIC("SUB",  RR,   0x80, 0x05, 0x00)
+    MNEMONIC("SHR",  RR,   0x80, 0x06, 0x00)
+    MNEMONIC("RSUB", RR,   0x80, 0x07, 0x00)
+    MNEMONIC("SHL",  RR,   0x80, 0x0E, 0x00)
+    MNEMONIC("IDX",  NNN,  0xA0, 0x00, 0x00)
+    MNEMONIC("JMP0", NNN,  0xB0, 0x00, 0x00)
+    MNEMONIC("RND",  RNN,  0xC0, 0x00, 0x00)
+    MNEMONIC("DRAW", RRN,  0xD0, 0x00, 0x00)
+    MNEMONIC("IFK",  R,    0xE0, 0x9E, 0x00)
+    MNEMONIC("IFNK", R,    0xE0, 0xA1, 0x00)
+    MNEMONIC("GDEL", R,    0xF0, 0x07, 0x00)
+    MNEMONIC("WKEY", R,    0xF0, 0x0A, 0x00)
+    MNEMONIC("SDEL", R,    0xF0, 0x15, 0x00)
+    MNEMONIC("SAUD", R,    0xF0, 0x18, 0x00)
+    MNEMONIC("IADD", R,    0xF0, 0x1E, 0x00)
+    MNEMONIC("CHAR", R,    0xF0, 0x29, 0x00)
+    MNEMONIC("SEP",  R,    0xF0, 0x33, 0x00)
+    MNEMONIC("STOR", N,    0xF0, 0x55, 0x00)
+    MNEMONIC("LOAD", N,    0xF0, 0x65, 0x00)
+    MNEMONIC("DATA", NNNN, 0x00, 0x00, 0x00)
+    default: return nullptr;
+  }
+#undef MNEMONIC
+}
+
+int hexDigit(char c) {
+  if (c >= '0' && c <= '9') { return c - '0'; }
+  if (c >= 'a' && c <= 'f') { return c - 'a' + 10; }
+  if (c >= 'A' && c <= 'F') { return c - 'A' + 10; }
+  return -1;
+}
+
+// Parses like stoi(text, 0, 16): optional sign and 0x, then hex digits up
+// to the first other character. Returns -1 if there are none or on overflow.
+long xtoi(char const* text, std::size_t size) {
+  std::size_t i = 0;
+  bool negative = false;
+  if (i < size && (text[i] == '+' || text[i] == '-')) {
+    negative = text[i++] == '-';
+  }
+  if (i + 2 < size && text[i] == '0'
+      && (text[i + 1] == 'x' || text[i + 1] == 'X')
+      && hexDigit(text[i + 2]) >= 0) {
+    i += 2;
+  }
+  if (i == size || hexDigit(text[i]) < 0) {
+    return -1;
+  }
+  long value = 0;
+  for (; i < size && hexDigit(text[i]) >= 0; ++i) {
+    value = value * 16 + hexDigit(text[i]);
+    if (value > 0x7FFFFFFF) {
+      return -1;
+    }
+  }
+  return negative ? -value : value;
+}
+
+// Assembles one source into output, recording diagnostics on the way
+class Parser {
+public:
+  Parser(char const* begin, char const* end, std::vector<uint8_t>& output,
+         std::vector<Assembler::Diagnostic>& diagnostics) :
+    lexer(begin, end), output(output), diagnostics(diagnostics) {}
+
+  void run() {
+    Token token;
+    while (lexer.next(token)) {
+      // A comment runs from a command starting with ';' to the end of line
+      if (token.data[0] == ';') {
+        lexer.skipLine();
+        continue;
+      }
+      Mnemonic const* const m = lookup(token);
+      if (m == nullptr) {
+        fail(token, "Unknown command '" + token.str() + "'");
+        lexer.skipLine();
+        continue;
+      }
+      if (!assemble(*m)) {
+        if (!failed) {
+          report(Assembler::Diagnostic::Warning, token,
+                 std::string("Incomplete ") + m->name
+                 + " at end of input is ignored");
+          return;
+        }
+        // Resume on the next line, so later errors are reported too
+        failed = false;
+        lexer.skipLine();
+      }
+    }
+  }
+
+private:
+  // Returns false at the end of input, or on error (failed is set)
+  bool assemble(Mnemonic const& m) {
+    long x, y, v;
+    switch (m.kind) {
+      case NONE:
+        emit(m.lop, m.rop);
+        return true;
+      case R:
+        if (!reg(m, x)) { return false; }
+        emit(m.lop + x, m.rop);
+        return true;
+      case RR:
+        if (!reg(m, x) || !reg(m, y)) { return false; }
+        emit(m.lop + x, (y << 4) + m.rop);
+        return true;
+      case N:
+        if (!value(m, 0xF, "[0-F]", x)) { return false; }
+        emit(m.lop + x, m.rop);
+        return true;
+      case NNN:
+        if (!value(m, 0xFFF, "[0-FFF]", v)) { return false; }
+        emit(m.lop + (v >> 8), v & 0xFF);
+        return true;
+      case RNN:
+        if (!reg(m, x) || !value(m, 0xFF, "[0-FF]", v)) { return false; }
+        emit(m.lop + x, v);
+        return true;
+      case RRN:
+        if (!reg(m, x) || !reg(m, y) || !value(m, 0xF, "[0-F]", v)) {
+          return false;
+        }
+        emit(m.lop + x, (y << 4) + v);
+        return true;
+      case RV: {
+        Token token;
+        if (!reg(m, x) || !lexer.next(token)) { return false; }
+        if (token.data[0] == 'r') {
+          if (!reg(m, token, y)) { return false; }
+          emit(m.rop + x, (y << 4) + m.rop2);
+        } else {
+          if (!value(m, token, 0xFF, "[0-FF]", v)) { return false; }
+          emit(m.lop + x, v);
+        }
+        return true;
+      }
+      case NNNN:
+        if (!value(m, 0xFFFF, "[0-FFFF]", v)) { return false; }
+        emit(v >> 8, v & 0xFF);
+        return true;
+    }
+    return false;
+  }
+
+  void emit(long lhs, long rhs) {
+    output.push_back(static_cast<uint8_t>(lhs));
+    output.push_back(static_cast<uint8_t>(rhs));
+  }
+
+  bool reg(Mnemonic const& m, long& out) {
+    Token token;
+    return lexer.next(token) && reg(m, token, out);
+  }
+
+  bool reg(Mnemonic const& m, Token const& token, long& out) {
+    out = token.data[0] == 'r' ? xtoi(token.data + 1, token.size - 1) : -1;
+    if (out < 0 || out > 0xF) {
+      return fail(token, std::string(m.name)
+                  + " needs to be supplied with a register r[0-F]");
+    }
+    return true;
+  }
+
+  bool value(Mnemonic const& m, long max, char const* range, long& out) {
+    Token token;
+    return lexer.next(token) && value(m, token, max, range, out);
+  }
+
+  bool value(Mnemonic const& m, Token const& token, long max,
+             char const* range, long& out) {
+    out = xtoi(token.data, token.size);
+    if (out < 0 || out > max) {
+      return fail(token, std::string(m.name)
+                  + " needs to be supplied with a value " + range);
+    }
+    return true;
+  }
+
+  bool fail(Token const& token, std::string const& message) {
+    report(Assembler::Diagnostic::Error, token, message);
+    failed = true;
+    return false;
+  }
+
+  void report(Assembler::Diagnostic::Severity severity, Token const& token,
+              std::string const& message) {
+    Assembler::Diagnostic const diagnostic =
+      { severity, token.line, token.column, message };
+    diagnostics.push_back(diagnostic);
+  }
+
+  Lexer                               lexer;
+  std::vector<uint8_t>&               output;
+  std::vector<Assembler::Diagnostic>& diagnostics;
+  bool                                failed = false;
+};
+
+} // anonymous namespace
+
+Assembler::Assembler() {}
+
+bool Assembler::assemble(char const* source, std::size_t size) {
+  output.clear();
+  diagnostics.clear();
+  error_msg.clear();
+
+  Parser parser(source, source + size, output, diagnostics);
+  parser.run();
+
+  for (Diagnostic const& diagnostic : diagnostics) {
+    if (diagnostic.severity == Diagnostic::Error) {
+      error_msg = "Line " + std::to_string(diagnostic.line) + ", column "
+        + std::to_string(diagnostic.column) + ": " + diagnostic.message;
+      output.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+bool Assembler::assemble(std::string const& source) {
+  return assemble(source.data(), source.size());
+}
+
+std::vector<uint8_t> const& Assembler::getOutput() const {
+  return output;
+}
+
+std::vector<Assembler::Diagnostic> const& Assembler::getDiagnostics() const {
+  return diagnostics;
+}
+
+std::string const& Assembler::getError() const {
+  return error_msg;
+}
@@ -0,0 +1,132 @@
+#include <algorithm>
+#include <iomanip>
+#include <map>
+
+#include "chip8core/CallProfiler.h"
+
+namespace {
+
+std::size_t constexpr root = 0;
+
+} // anonymous namespace
+
+CallProfiler::CallProfiler() :
+  nodes(),
+  current(root),
+  depth(0),
+  last_count(0),
+  started(false)
+  {
+    reset();
+}
+
+void CallProfiler::reset() {
+  Node const entry_point = { Emulator::program_counter_start, root, 0, 0, {} };
+  nodes.assign(1, entry_point);
+  current = root;
+  depth = 0;
+  started = false;
+}
+
+std::size_t CallProfiler::child(std::size_t parent, halfword entry) {
+  for (std::size_t index : nodes[parent].children) {
+    if (nodes[index].entry == entry) {
+      return index;
+    }
+  }
+
+  Node const node = { entry, parent, 0, 0, {} };
+  nodes.push_back(node);
+  nodes[parent].children.push_back(nodes.size() - 1);
+  return nodes.size() - 1;
+}
+
+void CallProfiler::observe(Emulator const& emulator) {
+  uint64_t const count = emulator.getInstructionCount();
+  if (started && count >= last_count) {
+    nodes[current].self += count - last_count;
+  }
+  last_count = count;
+  started = true;
+
+  unsigned const stack_depth = emulator.getStackDepth();
+  while (depth > stack_depth) {
+    current = nodes[current].parent;
+    --depth;
+  }
+  while (depth < stack_depth) {
+    current = child(current, emulator.getProgramCounter());
+    ++nodes[current].calls;
+    ++depth;
+  }
+}
+
+bool CallProfiler::tick(Emulator& emulator) {
+  bool const status = emulator.tick();
+  observe(emulator);
+  return status;
+}
+
+std::vector<CallProfiler::Function> CallProfiler::functions() const {
+  // Children are always added after their parent, so walking backwards
+  // sums up every subtree before it is needed
+  std::vector<uint64_t> totals(nodes.size());
+  for (std::size_t i = nodes.size(); i-- > 0; ) {
+    totals[i] += nodes[i].self;
+    if (i != root) {
+      totals[nodes[i].parent] += totals[i];
+    }
+  }
+
+  std::map<halfword, Function> by_entry;
+  for (std::size_t i = 0; i < nodes.size(); ++i) {
+    Node const& node = nodes[i];
+    Function& function = by_entry[node.entry];
+    function.entry = node.entry;
+    function.calls += node.calls;
+    function.exclusive += node.self;
+
+    bool recursive = false;
+    for (std::size_t up = i; up != root && !recursive; ) {
+      up = nodes[up].parent;
+      recursive = nodes[up].entry == node.entry;
+    }
+    if (!recursive) {
+      function.inclusive += totals[i];
+    }
+  }
+
+  std::vector<Function> result;
+  for (auto const& entry : by_entry) {
+    result.push_back(entry.second);
+  }
+  std::stable_sort(result.begin(), result.end(),
+                   [](Function const& lhs, Function const& rhs) {
+    return lhs.inclusive > rhs.inclusive;
+  });
+  return result;
+}
+
+void CallProfiler::writeFolded(std::ostream& out) const {
+  std::ios::fmtflags const flags = out.flags();
+  std::vector<halfword> path;
+  for (std::size_t i = 0; i < nodes.size(); ++i) {
+    if (nodes[i].self == 0) {
+      continue;
+    }
+
+    path.clear();
+    for (std::size_t up = i; ; up = nodes[up].parent) {
+      path.push_back(nodes[up].entry);
+      if (up == root) {
+        break;
+      }
+    }
+
+    for (std::size_t j = path.size(); j-- > 0; ) {
+      out << std::hex << path[j] << (j > 0 ? ";" : " ");
+    }
+    out << std::dec << nodes[i].self << "\n";
+  }
+  out.flags(flags);
+}
@@ -0,0 +1,138 @@
+#include <thread>
+#include <vector>
+
+#include "chip8core/CoEmulator.h"
+
+CoEmulator::CoEmulator(CoExecutor& owner, Emulator const& source) :
+  executor(owner),
+  emu(source),
+  waiting(Waiting::Nothing),
+  event_fired(false),
+  failed(false),
+  handle(nullptr),
+  error_msg()
+  {
+    emu.onGraphics = [this]() {
+      if (waiting == Waiting::Frame) { event_fired = true; }
+    };
+    emu.onSound = [this]() {
+      if (waiting == Waiting::Sound) { event_fired = true; }
+    };
+}
+
+CoEmulator::Awaiter CoEmulator::nextFrame() {
+  return Awaiter(*this, Waiting::Frame);
+}
+
+CoEmulator::Awaiter CoEmulator::keyWait() {
+  return Awaiter(*this, Waiting::Key);
+}
+
+CoEmulator::Awaiter CoEmulator::sound() {
+  return Awaiter(*this, Waiting::Sound);
+}
+
+Emulator& CoEmulator::emulator() {
+  return emu;
+}
+
+std::string const& CoEmulator::getError() const {
+  return error_msg;
+}
+
+bool CoEmulator::eventHappened() const {
+  if (waiting == Waiting::Key) {
+    return emu.isAwaitingKeypress();
+  }
+  return event_fired;
+}
+
+void CoEmulator::Awaiter::await_suspend(std::coroutine_handle<> handle) {
+  emulator.waiting = what;
+  emulator.event_fired = false;
+  emulator.handle = handle;
+  emulator.executor.schedule(emulator);
+}
+
+CoExecutor::CoExecutor(unsigned slice) :
+  ticks_per_slice(slice > 0 ? slice : 1),
+  lock(),
+  ready(),
+  waiting(0)
+  {}
+
+void CoExecutor::spawn(CoTask task) {
+  std::coroutine_handle<CoTask::promise_type> handle = task.handle;
+  task.handle = nullptr;
+  handle.resume();
+}
+
+void CoExecutor::schedule(CoEmulator& emulator) {
+  ++waiting;
+  std::lock_guard<std::mutex> guard(lock);
+  ready.push_back(&emulator);
+}
+
+void CoExecutor::run(unsigned num_threads) {
+  if (num_threads == 0) {
+    num_threads = std::thread::hardware_concurrency();
+  }
+
+  std::vector<std::thread> workers;
+  for (unsigned i = 1; i < num_threads; ++i) {
+    workers.emplace_back(&CoExecutor::work, this);
+  }
+  work();
+
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+void CoExecutor::work() {
+  while (waiting.load() > 0) {
+    CoEmulator* emulator = nullptr;
+    {
+      std::lock_guard<std::mutex> guard(lock);
+      if (!ready.empty()) {
+        emulator = ready.front();
+        ready.pop_front();
+      }
+    }
+
+    if (emulator == nullptr) {
+      // Everything left is being run by other workers right now
+      std::this_thread::yield();
+      continue;
+    }
+
+    if (!runSlice(*emulator)) {
+      std::lock_guard<std::mutex> guard(lock);
+      ready.push_back(emulator);
+      continue;
+    }
+
+    // The coroutine may co_await again, which schedules the emulator anew
+    // before we stop counting this wait
+    std::coroutine_handle<> handle = emulator->handle;
+    emulator->handle = nullptr;
+    emulator->waiting = CoEmulator::Waiting::Nothing;
+    handle.resume();
+    --waiting;
+  }
+}
+
+bool CoExecutor::runSlice(CoEmulator& emulator) {
+  for (unsigned i = 0; i < ticks_per_slice; ++i) {
+    if (emulator.eventHappened()) {
+      return true;
+    }
+
+    if (!emulator.emu.tick()) {
+      emulator.failed = true;
+      emulator.error_msg = emulator.emu.getError();
+      return true;
+    }
+  }
+  return emulator.eventHappened();
+}
@@ -0,0 +1,495 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "chip8core/DebugServer.h"
+
+namespace {
+
+std::size_t constexpr request_header_size = 7;
+std::size_t constexpr response_header_size = 3;
+
+// How long the socket thread waits for the emulation thread to call tick()
+auto constexpr serve_timeout = std::chrono::seconds(1);
+
+// How often blocked socket calls check whether the server is closing
+int constexpr poll_interval_ms = 100;
+
+unsigned constexpr index_register_number = 16;
+unsigned constexpr program_counter_number = 17;
+
+void put(byte* out, uint64_t value, unsigned bytes) {
+  for (unsigned i = 0; i < bytes; ++i) {
+    out[i] = (value >> (8 * i)) & 0xFF;
+  }
+}
+
+uint64_t get(byte const* in, unsigned bytes) {
+  uint64_t value = 0;
+  for (unsigned i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(in[i]) << (8 * i);
+  }
+  return value;
+}
+
+bool makeAddress(std::string const& path, sockaddr_un& address) {
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    return false;
+  }
+  memcpy(address.sun_path, path.c_str(), path.size());
+  return true;
+}
+
+// A socket nobody listens on refuses connections. Anything else, including
+// a full backlog, means a live server owns it.
+bool isStaleSocket(sockaddr_un const& address) {
+  int const fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return false;
+  }
+  bool const stale =
+    connect(fd, reinterpret_cast<sockaddr const*>(&address),
+            sizeof(address)) != 0
+    && errno == ECONNREFUSED;
+  ::close(fd);
+  return stale;
+}
+
+// Reads exactly length bytes, giving up when running turns false
+bool readFull(int fd, byte* out, std::size_t length,
+              std::atomic<bool> const* running) {
+  while (length > 0) {
+    if (running != nullptr) {
+      pollfd readable = { fd, POLLIN, 0 };
+      int const ready = poll(&readable, 1, poll_interval_ms);
+      if (!running->load()) {
+        return false;
+      }
+      if (ready == 0 || (ready < 0 && errno == EINTR)) {
+        continue;
+      }
+    }
+    ssize_t const got = recv(fd, out, length, 0);
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got <= 0) {
+      return false;
+    }
+    out += got;
+    length -= got;
+  }
+  return true;
+}
+
+bool writeFull(int fd, byte const* in, std::size_t length) {
+  while (length > 0) {
+    ssize_t const sent = send(fd, in, length, MSG_NOSIGNAL);
+    if (sent < 0 && errno == EINTR) {
+      continue;
+    }
+    if (sent <= 0) {
+      return false;
+    }
+    in += sent;
+    length -= sent;
+  }
+  return true;
+}
+
+void setMessage(std::vector<byte>& response, std::string const& message) {
+  response.assign(message.begin(), message.end());
+}
+
+} // anonymous namespace
+
+std::size_t constexpr DebugStatus::size;
+
+void DebugStatus::write(byte* out) const {
+  out[0] = paused;
+  out[1] = static_cast<byte>(stop_reason);
+  put(out + 2, stop_address, 2);
+  put(out + 4, program_counter, 2);
+  put(out + 6, index_register, 2);
+  out[8] = stack_depth;
+  memcpy(out + 9, registers, sizeof(registers));
+  put(out + 9 + sizeof(registers), instruction_count, 8);
+}
+
+DebugStatus DebugStatus::read(byte const* in) {
+  DebugStatus status;
+  status.paused = in[0] != 0;
+  status.stop_reason = static_cast<StopReason>(in[1]);
+  status.stop_address = get(in + 2, 2);
+  status.program_counter = get(in + 4, 2);
+  status.index_register = get(in + 6, 2);
+  status.stack_depth = in[8];
+  memcpy(status.registers, in + 9, sizeof(status.registers));
+  status.instruction_count = get(in + 9 + sizeof(status.registers), 8);
+  return status;
+}
+
+DebugServer::DebugServer() :
+  listen_fd(-1),
+  socket_path(),
+  thread(),
+  running(false),
+  pending(false),
+  mutex(),
+  served(),
+  request(),
+  response(),
+  response_ok(false),
+  done(false),
+  paused(false),
+  error_msg()
+  {}
+
+DebugServer::~DebugServer() {
+  close();
+}
+
+bool DebugServer::open(std::string const& path) {
+  close();
+
+  sockaddr_un address;
+  if (!makeAddress(path, address)) {
+    error_msg = "Socket path too long";
+    return false;
+  }
+
+  // Only replace a stale socket, never a file given by mistake or the
+  // socket of another running server
+  struct stat info;
+  if (lstat(path.c_str(), &info) == 0) {
+    if (!S_ISSOCK(info.st_mode)) {
+      error_msg = path + " exists and is not a socket";
+      return false;
+    }
+    if (!isStaleSocket(address)) {
+      error_msg = path + " is in use by another server";
+      return false;
+    }
+    unlink(path.c_str());
+  }
+
+  int const fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    error_msg = std::string("Could not create socket: ") + strerror(errno);
+    return false;
+  }
+  if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+      || listen(fd, 1) != 0) {
+    error_msg = "Could not listen on " + path + ": " + strerror(errno);
+    ::close(fd);
+    return false;
+  }
+
+  listen_fd = fd;
+  socket_path = path;
+  running = true;
+  thread = std::thread(&DebugServer::run, this);
+  return true;
+}
+
+void DebugServer::close() {
+  if (listen_fd < 0) {
+    return;
+  }
+  running = false;
+  thread.join();
+  ::close(listen_fd);
+  unlink(socket_path.c_str());
+  listen_fd = -1;
+  socket_path.clear();
+}
+
+bool DebugServer::tick(Emulator& emulator) {
+  if (pending.load(std::memory_order_acquire)) {
+    serve(emulator);
+  }
+  if (paused) {
+    return true;
+  }
+  return emulator.tick();
+}
+
+bool DebugServer::isPaused() const {
+  return paused;
+}
+
+std::string const& DebugServer::getError() const {
+  return error_msg;
+}
+
+void DebugServer::serve(Emulator& emulator) {
+  std::lock_guard<std::mutex> lock(mutex);
+  // The socket thread may have given up waiting
+  if (!pending.load(std::memory_order_relaxed)) {
+    return;
+  }
+  response.clear();
+  try {
+    response_ok = handle(emulator, request, response);
+  } catch (std::out_of_range const&) {
+    response_ok = false;
+    setMessage(response, "Out of range");
+  }
+  pending.store(false, std::memory_order_relaxed);
+  done = true;
+  served.notify_one();
+}
+
+bool DebugServer::handle(Emulator& emulator, Request const& request,
+                         std::vector<byte>& response) {
+  uint16_t const a = request.a;
+  uint16_t const b = request.b;
+
+  switch (request.command) {
+    case DebugCommand::Pause:
+      paused = true;
+      return true;
+
+    case DebugCommand::Continue:
+      paused = false;
+      emulator.resume();
+      return true;
+
+    case DebugCommand::Step:
+      paused = true;
+      emulator.resume();
+      for (unsigned i = 0; i < std::max<unsigned>(a, 1); ++i) {
+        if (!emulator.tick()) {
+          setMessage(response, emulator.getError());
+          return false;
+        }
+        if (emulator.getStopReason() != StopReason::None) {
+          break;
+        }
+      }
+      return true;
+
+    case DebugCommand::Status: {
+      DebugStatus status;
+      status.paused = paused;
+      status.stop_reason = emulator.getStopReason();
+      status.stop_address = emulator.getStopAddress();
+      status.program_counter = emulator.getProgramCounter();
+      status.index_register = emulator.getIndexRegister();
+      status.stack_depth = emulator.getStackDepth();
+      for (unsigned i = 0; i < Emulator::num_registers; ++i) {
+        status.registers[i] = emulator.getRegister(i);
+      }
+      status.instruction_count = emulator.getInstructionCount();
+      response.resize(DebugStatus::size);
+      status.write(response.data());
+      return true;
+    }
+
+    case DebugCommand::SetRegister:
+      if (a == index_register_number) {
+        emulator.setIndexRegister(b);
+      } else if (a == program_counter_number) {
+        emulator.setProgramCounter(b);
+      } else {
+        emulator.setRegister(a, static_cast<byte>(b));
+      }
+      return true;
+
+    case DebugCommand::ReadRam:
+      response.resize(b);
+      emulator.readRam(a, response.data(), b);
+      return true;
+
+    case DebugCommand::WriteRam:
+      emulator.writeRam(a, request.payload.data(), request.payload.size());
+      return true;
+
+    case DebugCommand::ReadScreen:
+      if (a + b > Emulator::screen_bytes) {
+        throw std::out_of_range("Screen data out of range");
+      }
+      response.assign(emulator.getGraphicsData() + a,
+                      emulator.getGraphicsData() + a + b);
+      return true;
+
+    case DebugCommand::WriteScreen:
+      emulator.writeGraphicsData(a, request.payload.data(),
+                                 request.payload.size());
+      return true;
+
+    case DebugCommand::SetBreakpoint:
+      emulator.setBreakpoint(a, b != 0);
+      return true;
+
+    case DebugCommand::SetWatchpoint:
+      if (request.payload.size() != 2) {
+        setMessage(response, "Expected watch type and on");
+        return false;
+      }
+      emulator.setWatchpoint(a, b,
+                             static_cast<WatchType>(request.payload[0] & 3),
+                             request.payload[1] != 0);
+      return true;
+
+    case DebugCommand::ClearDebugPoints:
+      emulator.clearDebugPoints();
+      return true;
+  }
+
+  setMessage(response, "Unknown command "
+             + std::to_string(static_cast<unsigned>(request.command)));
+  return false;
+}
+
+void DebugServer::run() {
+  while (running) {
+    pollfd readable = { listen_fd, POLLIN, 0 };
+    if (poll(&readable, 1, poll_interval_ms) <= 0) {
+      continue;
+    }
+    int const client = accept(listen_fd, nullptr, nullptr);
+    if (client >= 0) {
+      talk(client);
+      ::close(client);
+    }
+  }
+}
+
+void DebugServer::talk(int client) {
+  byte header[request_header_size];
+  while (readFull(client, header, sizeof(header), &running)) {
+    std::vector<byte> payload(get(header + 5, 2));
+    if (!readFull(client, payload.data(), payload.size(), &running)) {
+      return;
+    }
+
+    bool ok = false;
+    std::vector<byte> reply;
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      request.command = static_cast<DebugCommand>(header[0]);
+      request.a = get(header + 1, 2);
+      request.b = get(header + 3, 2);
+      request.payload.swap(payload);
+      done = false;
+      pending.store(true, std::memory_order_release);
+
+      if (served.wait_for(lock, serve_timeout, [this]() { return done; })) {
+        ok = response_ok;
+        reply.swap(response);
+      } else {
+        pending.store(false, std::memory_order_relaxed);
+        setMessage(reply, "Emulator not responding");
+      }
+    }
+
+    reply.resize(std::min<std::size_t>(reply.size(), 0xFFFF));
+    byte reply_header[response_header_size];
+    reply_header[0] = ok ? 0 : 1;
+    put(reply_header + 1, reply.size(), 2);
+    if (!writeFull(client, reply_header, sizeof(reply_header))
+        || !writeFull(client, reply.data(), reply.size())) {
+      return;
+    }
+  }
+}
+
+DebugClient::DebugClient() :
+  fd(-1),
+  error_msg()
+  {}
+
+DebugClient::~DebugClient() {
+  disconnect();
+}
+
+bool DebugClient::connect(std::string const& path) {
+  disconnect();
+
+  sockaddr_un address;
+  if (!makeAddress(path, address)) {
+    error_msg = "Socket path too long";
+    return false;
+  }
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    error_msg = std::string("Could not create socket: ") + strerror(errno);
+    return false;
+  }
+  if (::connect(fd, reinterpret_cast<sockaddr*>(&address),
+                sizeof(address)) != 0) {
+    error_msg = "Could not connect to " + path + ": " + strerror(errno);
+    disconnect();
+    return false;
+  }
+  return true;
+}
+
+void DebugClient::disconnect() {
+  if (fd >= 0) {
+    close(fd);
+    fd = -1;
+  }
+}
+
+bool DebugClient::request(DebugCommand command, uint16_t a, uint16_t b,
+                          std::vector<byte> const& payload,
+                          std::vector<byte>& response) {
+  if (fd < 0) {
+    error_msg = "Not connected";
+    return false;
+  }
+  if (payload.size() > 0xFFFF) {
+    error_msg = "Payload too big";
+    return false;
+  }
+
+  byte header[request_header_size];
+  header[0] = static_cast<byte>(command);
+  put(header + 1, a, 2);
+  put(header + 3, b, 2);
+  put(header + 5, payload.size(), 2);
+  if (!writeFull(fd, header, sizeof(header))
+      || !writeFull(fd, payload.data(), payload.size())) {
+    error_msg = "Connection lost";
+    return false;
+  }
+
+  byte reply_header[response_header_size];
+  if (!readFull(fd, reply_header, sizeof(reply_header), nullptr)) {
+    error_msg = "Connection lost";
+    return false;
+  }
+  std::vector<byte> reply(get(reply_header + 1, 2));
+  if (!readFull(fd, reply.data(), reply.size(), nullptr)) {
+    error_msg = "Connection lost";
+    return false;
+  }
+
+  if (reply_header[0] != 0) {
+    error_msg.assign(reply.begin(), reply.end());
+    return false;
+  }
+  response.swap(reply);
+  return true;
+}
+
+bool DebugClient::request(DebugCommand command, uint16_t a, uint16_t b) {
+  std::vector<byte> response;
+  return request(command, a, b, std::vector<byte>(), response);
+}
+
+std::string const& DebugClient::getError() const {
+  return error_msg;
+}
@@ -0,0 +1,227 @@
+#include <iomanip>
+#include <ostream>
+
+#include "chip8core/Disassembler.h"
+
+namespace {
+
+inline int op_x_value(int opcode) {
+  return (opcode & 0x0F00) >> 8;
+}
+inline int op_y_value(int opcode) {
+  return (opcode & 0x00F0) >> 4;
+}
+inline int op_z_value(int opcode) {
+  return opcode & 0x000F;
+}
+inline int op_nnn_value(int opcode) {
+  return opcode & 0x0FFF;
+}
+inline int op_nn_value(int opcode) {
+  return opcode & 0x00FF;
+}
+
+} // anonymous namespace
+
+void describeOpcode(std::ostream& out, int line, int opcode) {
+  std::ios::fmtflags const flags = out.flags();
+  char const fill = out.fill();
+
+  out
+    << "L" << std::hex << line << ": "
+    << std::hex << std::setfill('0') << std::setw(4) << opcode << " - ";
+
+  switch (opcode & 0xF000) {
+    case 0x0000:
+      switch (opcode) {
+        case 0x00E0: out << "Clear screen"; break;
+        case 0x00EE: out << "RET"; break;
+        default:     out << "RCA 1802 (deprecated opcode)"; break;
+      } break;
+
+    case 0x1000:
+      out << "JMP " << std::hex << std::setfill('0') << std::setw(3) << op_nnn_value(opcode);
+      break;
+
+    case 0x2000:
+      out << "CALL " << std::hex << std::setfill('0') << std::setw(3) << op_nnn_value(opcode);
+      break;
+
+    case 0x3000:
+      out << "IF reg[" << std::hex << op_x_value(opcode)
+           << "] != " << std::hex << std::setfill('0') << std::setw(2) << op_nn_value(opcode) << ":";
+      break;
+
+    case 0x4000:
+      out << "IF reg[" << std::hex << op_x_value(opcode)
+           << "] == " << std::hex << std::setfill('0') << std::setw(2) << op_nn_value(opcode) << ":";
+      break;
+
+    case 0x5000:
+      out << "IF reg[" << std::hex << op_x_value(opcode)
+           << "] != reg[" << std::hex << op_y_value(opcode) << "]:";
+      break;
+
+    case 0x6000:
+      out << "reg[" << std::hex << op_x_value(opcode)
+           << "] = " << std::hex << std::setfill('0') << std::setw(2) << op_nn_value(opcode);
+      break;
+
+    case 0x7000:
+      out << "reg[" << std::hex << op_x_value(opcode)
+           << "] += " << std::hex << std::setfill('0') << std::setw(2) << op_nn_value(opcode);
+      break;
+
+    case 0x8000:
+      switch (opcode & 0xF00F) {
+        case 0x8000:
+          out << "reg[" << std::hex << op_x_value(opcode)
+               << "] = reg[" << std::hex << op_y_value(opcode) << "]";
+          break;
+
+        case 0x8001:
+          out << "reg[" << std::hex << op_x_value(opcode)
+               << "] |= reg[" << std::hex << op_y_value(opcode) << "]";
+          break;
+
+        case 0x8002:
+          out << "reg[" << std::hex << op_x_value(opcode)
+               << "] &= reg[" << std::hex << op_y_value(opcode) << "]";
+          break;
+
+        case 0x8003:
+          out << "reg[" << std::hex << op_x_value(opcode)
+               << "] ^= reg[" << std::hex << op_y_value(opcode) << "]";
+          break;
+
+        case 0x8004:
+          out << "reg[" << std::hex << op_x_value(opcode)
+               << "] += reg[" << std::hex << op_y_value(opcode)
+               << "] (modifies reg[f])";
+          break;
+
+        case 0x8005:
+          out << "reg[" << std::hex << op_x_value(opcode)
+               << "] -= reg[" << std::hex << op_y_value(opcode)
+               << "] (modifies reg[f])";
+          break;
+
+        case 0x8006:
+          out << "reg[" << std::hex << op_x_value(opcode)
+               << "] = reg[" << std::hex << op_y_value(opcode)
+               << "] >>= 1 (modifies reg[f])";
+          break;
+
+        case 0x8007:
+          out << "reg[" << std::hex << op_x_value(opcode)
+               << "] = reg[" << std::hex << op_y_value(opcode)
+               << "] - reg[" << std::hex << op_x_value(opcode)
+               << "] (modifies reg[f])";
+          break;
+
+        case 0x800E:
+          out << "reg[" << std::hex << op_x_value(opcode)
+               << "] = reg[" << std::hex << op_y_value(opcode)
+               << "] <<= 1 (modifies reg[f])";
+          break;
+
+        default:
+          out << "<Possibly a sprite?>";
+          break;
+      } break;
+
+    case 0x9000:
+          out << "IF reg[" << std::hex << op_x_value(opcode)
+               << "] == reg[" << std::hex << op_y_value(opcode)
+               << "]:";
+          break;
+
+    case 0xa000:
+          out << "I = " << std::hex << std::setw(3) << std::setfill('0') << op_nnn_value(opcode);
+          break;
+
+    case 0xb000:
+          out << "JMP " << std::hex << std::setw(3) << std::setfill('0') << op_nnn_value(opcode)
+               << " + reg[0]";
+          break;
+
+    case 0xc000:
+          out << "reg[" << std::hex << op_x_value(opcode) << "] = rand() & "
+               << std::hex << std::setw(2) << std::setfill('0') << op_nn_value(opcode);
+          break;
+
+    case 0xd000:
+          out << "DRAW " << op_z_value(opcode) << " sprites to x/y: reg["
+               << std::hex << op_x_value(opcode) << "]/reg["
+               << std::hex << op_y_value(opcode) << "]";
+          break;
+
+    case 0xe000:
+          switch (opcode & 0xF0FF) {
+            case 0xE09E:
+              out << "IF KEY PRESSED @ reg[" << std::hex << op_x_value(opcode)
+                   << "]:";
+              break;
+
+            case 0xE0A1:
+              out << "IF KEY NOT PRESSED @ reg[" << std::hex << op_x_value(opcode)
+                   << "]:";
+              break;
+
+            default:
+              out << "<Possibly a sprite?>";
+              break;
+          } break;
+
+    case 0xf000:
+        switch (opcode & 0xF0FF) {
+          case 0xF007:
+            out << "reg[" << std::hex << op_x_value(opcode) << "] = delay_timer";
+            break;
+
+          case 0xF00A:
+            out << "AWAIT KEYPRESS TO reg[" << std::hex << op_x_value(opcode) << "]";
+            break;
+
+          case 0xF015:
+            out << "delay_timer = reg[" << std::hex << op_x_value(opcode) << "]";
+            break;
+
+          case 0xF018:
+            out << "sound_timer = reg[" << std::hex << op_x_value(opcode) << "]";
+            break;
+
+          case 0xF01E:
+            out << "I += reg[" << std::hex << op_x_value(opcode) << "] (modifies reg[f])";
+            break;
+
+          case 0xF029:
+            out << "I = character representation of reg[" << std::hex << op_x_value(opcode)
+                 << "]";
+            break;
+
+          case 0xF033:
+            out << "Write reg[" << std::hex << op_x_value(opcode) << "] to I/I+1/I+2";
+            break;
+
+          case 0xF055:
+            out << "STORE data from reg[0] - reg[" << std::hex << op_x_value(opcode)
+                 << "] to I";
+            break;
+
+          case 0xF065:
+            out << "LOAD data from I to reg[0] - reg[" << std::hex << op_x_value(opcode)
+                 << "]";
+            break;
+
+          default:
+            out << "<Possibly a sprite?>";
+            break;
+        }
+      break;
+  }
+
+  out << "\n";
+  out.flags(flags);
+  out.fill(fill);
+}
@@ -1,13 +1,38 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstring>
 #include <iomanip>
 #include <iostream>
-#include <fstream>
 #include <sstream>
 #include <vector>
-#include <cstdlib>
 #include <ctime>
 
 #include "chip8core/Emulator.h"
+#include "chip8core/WriteProvenance.h"
+
+// Counting compiles to nothing unless the counters are enabled
+#ifdef CHIP8CORE_OPCODE_COUNTERS
+#define COUNT(statement) (opcode_counters.statement)
+#else
+#define COUNT(statement) ((void)0)
+#endif
+
+// USDT probes for bpftrace and SystemTap, e.g.
+//   bpftrace -e 'usdt:./emulator:chip8core:fault { printf("%s\n", str(arg2)); }'
+// A probe is a single nop until a tracer attaches to it.
+#ifdef CHIP8CORE_USDT
+#include <sys/sdt.h>
+#define PROBE0(name) DTRACE_PROBE(chip8core, name)
+#define PROBE1(name, a) DTRACE_PROBE1(chip8core, name, a)
+#define PROBE2(name, a, b) DTRACE_PROBE2(chip8core, name, a, b)
+#define PROBE3(name, a, b, c) DTRACE_PROBE3(chip8core, name, a, b, c)
+#else
+#define PROBE0(name) ((void)0)
+#define PROBE1(name, a) ((void)0)
+#define PROBE2(name, a, b) ((void)0)
+#define PROBE3(name, a, b, c) ((void)0)
+#endif
 
 unsigned constexpr Emulator::ram_size;
 unsigned constexpr Emulator::num_registers;
@@ -16,34 +41,83 @@ unsigned constexpr Emulator::screen_rows;
 unsigned constexpr Emulator::screen_bytes;
 unsigned constexpr Emulator::stack_size;
 unsigned constexpr Emulator::num_keys;
+unsigned constexpr Emulator::ram_page_size;
 halfword constexpr Emulator::program_counter_start;
+bool constexpr Emulator::has_opcode_counters;
+uint16_t constexpr Emulator::state_version;
+std::size_t constexpr Emulator::state_size;
+
+namespace {
+
+byte const state_magic[4] = { 'C', '8', 'S', 'T' };
+
+inline byte* put16(byte* out, uint16_t value) {
+  out[0] = value & 0xFF;
+  out[1] = value >> 8;
+  return out + 2;
+}
+
+inline uint16_t get16(byte const* in) {
+  return in[0] | (in[1] << 8);
+}
+
+} // anonymous namespace
 
 
 
 Emulator::Emulator() :
   onSound(nullptr),
   onGraphics(nullptr),
-  ram(std::vector<byte>(ram_size, 0)),
-  screen(std::vector<screen_row>(screen_bytes, 0)),
-  registers(std::vector<byte>(num_registers, 0)),
+  ram(),
+  screen(),
+  registers(),
   index_register(0),
   program_counter(program_counter_start),
   sound_timer(0),
   delay_timer(0),
-  stack(std::vector<halfword>(stack_size, 0)),
+  stack(),
   stack_pointer(0),
-  keys_state(std::vector<byte>(num_keys, 0)),
+  keys_state(),
   error_msg(),
   tick_lock(false),
   awaiting_keypress(false),
-  awaiting_keypress_register(0)
+  awaiting_keypress_register(0),
+  rng_state(0),
+  rng_seed(0),
+  instruction_count(0),
+  fault_type(FaultType::None),
+  runtime_counters(),
+  rom_analysis(),
+  modified_pages(),
+  debug_points(),
+  write_provenance(nullptr),
+  debug_active(false),
+  step_over_breakpoint(false),
+  stop_reason(StopReason::None),
+  stop_address(0)
+#ifdef CHIP8CORE_OPCODE_COUNTERS
+  , opcode_counters()
+#endif
   {
-    srand(time(NULL));
+    // Instances created in the same second still get different seeds
+    static std::atomic<uint32_t> instances(0);
+    setSeed(time(NULL) ^ (instances++ * 0x9E3779B9U));
     addFontDataToRam();
 }
 
 void Emulator::resetState() {
+  PROBE0(reset);
+  std::shared_ptr<DebugPoints> points = debug_points;
+  WriteProvenance* provenance = write_provenance;
+  uint32_t const seed = rng_seed;
   *this = Emulator();
+  debug_points = points;
+  write_provenance = provenance;
+  setSeed(seed);
+  if (write_provenance != nullptr) {
+    write_provenance->clear();
+  }
+  updateDebugActive();
 }
 
 void Emulator::addFontDataToRam() {
@@ -66,57 +140,446 @@ void Emulator::addFontDataToRam() {
     0xF0, 0x80, 0xF0, 0x80, 0xF0, //E
     0xF0, 0x80, 0xF0, 0x80, 0x80  //F
   };
-  memcpy(ram.data(), font.data(), font.size());
+  ram.write(0, font.data(), font.size());
+}
+
+void Emulator::setSeed(uint32_t seed) {
+  // xorshift32 gets stuck on zero, so map it to an arbitrary non-zero value
+  rng_state = seed != 0 ? seed : 0x2545F491U;
+  rng_seed = rng_state;
 }
 
 std::string const& Emulator::getError() const {
   return error_msg;
 }
 
+Emulator Emulator::fork() const {
+  Emulator child(*this);
+  child.onSound = nullptr;
+  child.onGraphics = nullptr;
+  child.updateDebugActive();
+  child.error_msg.clear();
+  return child;
+}
+
 byte const* Emulator::getGraphicsData() const {
   return screen.data();
 }
 
+halfword Emulator::getProgramCounter() const {
+  return program_counter;
+}
+
+byte Emulator::getRegister(unsigned index) const {
+  return registers.at(index);
+}
+
+halfword Emulator::getIndexRegister() const {
+  return index_register;
+}
+
+unsigned Emulator::getStackDepth() const {
+  return stack_pointer;
+}
+
+void Emulator::readRam(halfword address, byte* out, std::size_t length) const {
+  ram.read(address, out, length);
+}
+
+void Emulator::setRegister(unsigned index, byte value) {
+  registers.at(index) = value;
+}
+
+void Emulator::setIndexRegister(halfword value) {
+  index_register = value;
+}
+
+void Emulator::setProgramCounter(halfword address) {
+  program_counter = address;
+}
+
+void Emulator::writeRam(halfword address, byte const* in, std::size_t length) {
+  ram.write(address, in, length);
+  markRamModified(address, length);
+}
+
+void Emulator::writeGraphicsData(std::size_t offset, byte const* in,
+                                 std::size_t length) {
+  if (offset + length > screen_bytes) {
+    throw std::out_of_range("Screen data out of range");
+  }
+  std::copy(in, in + length, screen.begin() + offset);
+  notifyGraphics();
+}
+
+uint64_t Emulator::getInstructionCount() const {
+  return instruction_count;
+}
+
 void Emulator::setKeyState(int key_number, bool on) {
   keys_state.at(key_number) = on ? 0xFF : 0x00;
 
   if (awaiting_keypress) {
     registers.at(awaiting_keypress_register) = key_number;
     awaiting_keypress = false;
+    PROBE2(key_wait_end, key_number, awaiting_keypress_register);
   }
 }
 
-bool Emulator::loadFileToRam(std::string const& filename) {
-  std::ifstream file(filename, std::ios::binary|std::ios::ate);
-  ssize_t filesize = file.tellg();
-  ssize_t available_ram = ram_size - program_counter;
+bool Emulator::isAwaitingKeypress() const {
+  return awaiting_keypress;
+}
 
-  if (filesize <= 0) {
-    error_msg = "File empty or not found";
+bool Emulator::loadFileToRam(std::string const& filename) {
+  RomImage rom;
+  if (!rom.mapFile(filename)) {
+    error_msg = rom.getError();
     return false;
+  }
 
-  } else if (filesize > available_ram) {
+  std::size_t const available_ram = ram_size - program_counter_start;
+  if (rom.size() > available_ram) {
     error_msg = "File too big. Only " + std::to_string(available_ram)
-              + " bytes available. File is " + std::to_string(filesize) + " bytes";
+              + " bytes available. File is " + std::to_string(rom.size()) + " bytes";
+    return false;
+  }
+
+  return loadRom(rom);
+}
+
+bool Emulator::loadRom(byte const* data, std::size_t size) {
+  std::size_t const available_ram = ram_size - program_counter_start;
+
+  if (size == 0) {
+    error_msg = "ROM is empty";
+    return false;
+
+  } else if (size > available_ram) {
+    error_msg = "ROM too big. Only " + std::to_string(available_ram)
+              + " bytes available. ROM is " + std::to_string(size) + " bytes";
     return false;
   }
 
   tick_lock = true;
-  file.seekg(0, std::ios::beg);
   resetState();
-  file.read(reinterpret_cast<char *>(&ram.data()[program_counter]), filesize);
+  ram.write(program_counter, data, size);
+  rom_analysis = RomAnalysis::get(data, size);
+  PROBE2(rom_load, data, size);
 
   tick_lock = false;
   return true;
 }
 
+bool Emulator::loadRom(RomImage const& rom) {
+  return loadRom(rom.data(), rom.size());
+}
+
+RuntimeCounters const& Emulator::getRuntimeCounters() const {
+  return runtime_counters;
+}
+
+void Emulator::resetRuntimeCounters() {
+  runtime_counters = RuntimeCounters();
+}
+
+FaultType Emulator::getFault() const {
+  return fault_type;
+}
+
+bool Emulator::fault(FaultType type, std::string const& message) {
+  fault_type = type;
+  error_msg = message;
+  PROBE3(fault, static_cast<unsigned>(type), program_counter, error_msg.c_str());
+  return false;
+}
+
+void Emulator::notifyGraphics() {
+  ++runtime_counters.frames;
+  if (onGraphics != nullptr) {
+    PROBE1(graphics, runtime_counters.frames);
+    auto const start = std::chrono::steady_clock::now();
+    onGraphics();
+    ++runtime_counters.graphics_callbacks;
+    runtime_counters.graphics_callback_ns +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+void Emulator::notifySound() {
+  if (onSound != nullptr) {
+    auto const start = std::chrono::steady_clock::now();
+    onSound();
+    ++runtime_counters.sound_callbacks;
+    runtime_counters.sound_callback_ns +=
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+  }
+}
+
+OpcodeCounters Emulator::getOpcodeCounters() const {
+#ifdef CHIP8CORE_OPCODE_COUNTERS
+  return opcode_counters;
+#else
+  return OpcodeCounters();
+#endif
+}
+
+void Emulator::resetOpcodeCounters() {
+#ifdef CHIP8CORE_OPCODE_COUNTERS
+  opcode_counters = OpcodeCounters();
+#endif
+}
+
+void Emulator::setBreakpoint(halfword address, bool on) {
+  writableDebugPoints().breakpoints.set(address, on);
+  updateDebugActive();
+}
+
+void Emulator::setWatchpoint(halfword address, std::size_t length,
+                             WatchType type, bool on) {
+  if (address + length > ram_size) {
+    throw std::out_of_range("Watchpoint outside of RAM");
+  }
+  DebugPoints& points = writableDebugPoints();
+  for (std::size_t i = address; i < address + length; ++i) {
+    if (type & WatchRead) {
+      points.read_watchpoints.set(i, on);
+    }
+    if (type & WatchWrite) {
+      points.write_watchpoints.set(i, on);
+    }
+  }
+  updateDebugActive();
+}
+
+void Emulator::setWriteProvenance(WriteProvenance* provenance) {
+  write_provenance = provenance;
+  updateDebugActive();
+}
+
+void Emulator::clearDebugPoints() {
+  debug_points.reset();
+  updateDebugActive();
+}
+
+StopReason Emulator::getStopReason() const {
+  return stop_reason;
+}
+
+halfword Emulator::getStopAddress() const {
+  return stop_address;
+}
+
+void Emulator::resume() {
+  step_over_breakpoint = stop_reason == StopReason::Breakpoint;
+  stop_reason = StopReason::None;
+  updateDebugActive();
+}
+
+Emulator::DebugPoints& Emulator::writableDebugPoints() {
+  if (!debug_points) {
+    debug_points = std::make_shared<DebugPoints>();
+  } else if (debug_points.use_count() > 1) {
+    debug_points = std::make_shared<DebugPoints>(*debug_points);
+  }
+  return *debug_points;
+}
+
+void Emulator::updateDebugActive() {
+  bool const any_points = debug_points
+    && (debug_points->breakpoints.any()
+        || debug_points->read_watchpoints.any()
+        || debug_points->write_watchpoints.any());
+  if (!any_points) {
+    debug_points.reset();
+  }
+  debug_active = any_points || stop_reason != StopReason::None
+              || write_provenance != nullptr;
+}
+
+bool Emulator::checkBreakpoint() {
+  if (stop_reason != StopReason::None) {
+    return true;
+  }
+  if (step_over_breakpoint) {
+    step_over_breakpoint = false;
+    return false;
+  }
+  if (debug_points && program_counter < ram_size
+      && debug_points->breakpoints.test(program_counter)) {
+    stop_reason = StopReason::Breakpoint;
+    stop_address = program_counter;
+    PROBE1(breakpoint, program_counter);
+    return true;
+  }
+  return false;
+}
+
+void Emulator::checkWatchpoints(halfword address, std::size_t length,
+                                bool write) {
+  if (!debug_points) {
+    return;
+  }
+  std::bitset<ram_size> const& watched = write
+    ? debug_points->write_watchpoints
+    : debug_points->read_watchpoints;
+  std::size_t const end = std::min<std::size_t>(address + length, ram_size);
+  for (std::size_t i = address; i < end; ++i) {
+    if (watched.test(i)) {
+      stop_reason = write ? StopReason::WriteWatchpoint
+                          : StopReason::ReadWatchpoint;
+      stop_address = i;
+      debug_active = true;
+      PROBE2(watchpoint, i, write);
+      return;
+    }
+  }
+}
+
+// Both are called from the handler, after the program counter has moved on
+
+void Emulator::recordRamWrite(halfword address, std::size_t length) {
+  if (write_provenance != nullptr) {
+    write_provenance->recordRam(address, length, program_counter - 2,
+                                instruction_count);
+  }
+}
+
+void Emulator::recordScreenChange(std::size_t offset) {
+  if (write_provenance != nullptr) {
+    write_provenance->recordScreen(offset, program_counter - 2,
+                                   instruction_count);
+  }
+}
+
+std::shared_ptr<RomAnalysis const> const& Emulator::getRomAnalysis() const {
+  return rom_analysis;
+}
+
+void Emulator::markRamModified(std::size_t address, std::size_t length) {
+  std::size_t const end = std::min<std::size_t>(address + length, ram_size);
+  for (std::size_t page = address / ram_page_size;
+       address < end && page <= (end - 1) / ram_page_size; ++page) {
+    modified_pages.set(page);
+  }
+}
+
+void Emulator::updateModifiedPages() {
+  // After RAM was replaced wholesale, only pages which differ from the ROM
+  // count as modified
+  modified_pages.reset();
+  if (!rom_analysis) {
+    return;
+  }
+
+  std::array<byte, ram_page_size> page;
+  std::size_t const rom_end = RomAnalysis::start_address + rom_analysis->size();
+  for (std::size_t start = RomAnalysis::start_address; start < rom_end; ) {
+    std::size_t const length = std::min(ram_page_size - start % ram_page_size,
+                                        rom_end - start);
+    ram.read(start, page.data(), length);
+    if (memcmp(page.data(),
+               rom_analysis->data() + start - RomAnalysis::start_address,
+               length) != 0) {
+      modified_pages.set(start / ram_page_size);
+    }
+    start += length;
+  }
+}
+
+std::size_t Emulator::saveState(byte* buffer, std::size_t size) const {
+  if (size < state_size) {
+    return 0;
+  }
+
+  byte* out = buffer;
+  memcpy(out, state_magic, sizeof(state_magic)); out += sizeof(state_magic);
+  out = put16(out, state_version);
+  out = put16(out, 0);
+  ram.read(0, out, ram_size);                     out += ram_size;
+  memcpy(out, screen.data(), screen_bytes);       out += screen_bytes;
+  memcpy(out, registers.data(), num_registers);   out += num_registers;
+  for (halfword value : stack) {
+    out = put16(out, value);
+  }
+  memcpy(out, keys_state.data(), num_keys);       out += num_keys;
+  out = put16(out, index_register);
+  out = put16(out, program_counter);
+  *out++ = stack_pointer;
+  *out++ = delay_timer;
+  *out++ = sound_timer;
+  *out++ = awaiting_keypress;
+  *out++ = awaiting_keypress_register;
+  *out++ = 0;
+  out = put16(out, rng_state & 0xFFFF);
+  out = put16(out, rng_state >> 16);
+
+  return out - buffer;
+}
+
+std::vector<byte> Emulator::saveState() const {
+  std::vector<byte> buffer(state_size);
+  saveState(buffer.data(), buffer.size());
+  return buffer;
+}
+
+bool Emulator::loadState(byte const* buffer, std::size_t size) {
+  if (size < state_size || memcmp(buffer, state_magic, sizeof(state_magic)) != 0) {
+    error_msg = "Not a save state";
+    return false;
+  }
+
+  byte const* in = buffer + sizeof(state_magic);
+  if (get16(in) != state_version) {
+    error_msg = "Unsupported save state version " + std::to_string(get16(in));
+    return false;
+  }
+  in += 4;
+
+  // Validate before changing anything
+  byte const* const tail = in + ram_size + screen_bytes + num_registers
+                         + stack_size * 2 + num_keys;
+  if (tail[4] > stack_size || tail[8] >= num_registers) {
+    error_msg = "Corrupt save state";
+    return false;
+  }
+
+  ram.write(0, in, ram_size);                     in += ram_size;
+  memcpy(screen.data(), in, screen_bytes);        in += screen_bytes;
+  memcpy(registers.data(), in, num_registers);    in += num_registers;
+  for (halfword& value : stack) {
+    value = get16(in); in += 2;
+  }
+  memcpy(keys_state.data(), in, num_keys);        in += num_keys;
+  index_register = get16(in);                     in += 2;
+  program_counter = get16(in);                    in += 2;
+  stack_pointer = *in++;
+  delay_timer = *in++;
+  sound_timer = *in++;
+  awaiting_keypress = *in++ != 0;
+  awaiting_keypress_register = *in++;
+  in++;
+  setSeed(get16(in) | (static_cast<uint32_t>(get16(in + 2)) << 16));
+  updateModifiedPages();
+
+  return true;
+}
+
 halfword Emulator::fetchOpcode() {
   if (program_counter >= ram_size - 1) {
-    error_msg = "Program counter out of bounds";
+    fault(FaultType::ProgramCounterOutOfBounds, "Program counter out of bounds");
     return 0xFFFFU;
   }
 
-  halfword opcode = (ram.at(program_counter) << 8) + ram.at(program_counter +1);
+  halfword opcode;
+  if (rom_analysis && rom_analysis->contains(program_counter)
+      && !modified_pages.test(program_counter / ram_page_size)
+      && !modified_pages.test((program_counter + 1) / ram_page_size)) {
+    opcode = rom_analysis->opcode(program_counter);
+  } else {
+    opcode = (ram.get(program_counter) << 8) + ram.get(program_counter +1);
+  }
   increment_pc();
   return opcode;
 }
@@ -126,15 +589,22 @@ bool Emulator::handleOpcode0(halfword opcode) {
 
     // 0x00E0 - Clears the screen
     case 0x00E0:
-      std::fill(screen.begin(), screen.end(), 0);
-      if (onGraphics != nullptr) { onGraphics(); }
+      if (debug_active && write_provenance != nullptr) {
+        for (std::size_t i = 0; i < screen_bytes; ++i) {
+          if (screen[i] != 0) {
+            recordScreenChange(i);
+          }
+        }
+      }
+      screen.fill(0);
+      notifyGraphics();
       return true;
 
     // 0x00EE - Returns from subroutine
     case 0x00EE:
       if (stack_pointer == 0) {
-        error_msg = "Stack underflow";
-        return false;
+        PROBE1(stack_underflow, program_counter);
+        return fault(FaultType::StackUnderflow, "Stack underflow");
       }
       program_counter = stack.at(--stack_pointer);
       return true;
@@ -144,8 +614,7 @@ bool Emulator::handleOpcode0(halfword opcode) {
       std::stringstream ss;
       ss << "Opcode " << std::hex << std::setw(4) << std::setfill('0')
          << opcode << " not implemented";
-      error_msg = ss.str();
-      return false;
+      return fault(FaultType::UnknownOpcode, ss.str());
     }
   }
 }
@@ -159,8 +628,8 @@ inline bool Emulator::handleOpcode1(halfword opcode) {
 inline bool Emulator::handleOpcode2(halfword opcode) {
   // 0x2NNN - Call subroutine at opcode & 0x0FFF
   if (stack_pointer >= stack_size) {
-    error_msg = "Stack overflow";
-    return false;
+    PROBE2(stack_overflow, program_counter, stack_pointer);
+    return fault(FaultType::StackOverflow, "Stack overflow");
   }
   stack.at(stack_pointer++) = program_counter;
   program_counter = op_nnn_value(opcode);
@@ -169,13 +638,13 @@ inline bool Emulator::handleOpcode2(halfword opcode) {
 
 inline bool Emulator::handleOpcode3(halfword opcode) {
   // 0x3XNN - Skips the next instruction if VX equals NN.
-  if (vx_register(opcode) == op_nn_value(opcode)) { increment_pc(); }
+  if (vx_register(opcode) == op_nn_value(opcode)) { increment_pc(); COUNT(skips++); }
   return true;
 }
 
 inline bool Emulator::handleOpcode4(halfword opcode) {
   // 0x4XNN - Skips the next instruction if VX doesn't equal NN.
-  if (vx_register(opcode) != op_nn_value(opcode)) { increment_pc(); }
+  if (vx_register(opcode) != op_nn_value(opcode)) { increment_pc(); COUNT(skips++); }
   return true;
 }
 
@@ -183,7 +652,7 @@ inline bool Emulator::handleOpcode5(halfword opcode) {
   // 0x5XY0 - Skips the next instruction if VX equals VY
   // NOTE: At the moment, ignore the 0x000F value, but it's possible that this
   // should raise an error
-  if (vx_register(opcode) == vy_register(opcode)) { increment_pc(); }
+  if (vx_register(opcode) == vy_register(opcode)) { increment_pc(); COUNT(skips++); }
   return true;
 }
 
@@ -200,6 +669,7 @@ inline bool Emulator::handleOpcode7(halfword opcode) {
 }
 
 bool Emulator::handleOpcode8(halfword opcode) {
+  COUNT(arithmetic[opcode & 0x000F]++);
   switch (op_z_value(opcode)) {
 
     // 0x8XY0 - Set VX to VY
@@ -254,8 +724,7 @@ bool Emulator::handleOpcode8(halfword opcode) {
       std::stringstream ss;
       ss << "Opcode " << std::hex << std::setw(4) << std::setfill('0')
          << opcode << " not implemented";
-      error_msg = ss.str();
-      return false;
+      return fault(FaultType::UnknownOpcode, ss.str());
     }
   }
 }
@@ -264,7 +733,7 @@ inline bool Emulator::handleOpcode9(halfword opcode) {
   // 0x9XY0 - Skips the next instruction if VX doesn't equal VY.
   // NOTE: At the moment, ignore the 0x000F value, but it's possible that this
   // should raise an error
-  if (vx_register(opcode) != vy_register(opcode)) { increment_pc(); }
+  if (vx_register(opcode) != vy_register(opcode)) { increment_pc(); COUNT(skips++); }
   return true;
 }
 
@@ -282,7 +751,7 @@ inline bool Emulator::handleOpcodeB(halfword opcode) {
 
 bool Emulator::handleOpcodeC(halfword opcode) {
   // 0xCXNN - Sets VX to a bitwise and operation on a random number and NN.
-  vx_register(opcode) = (rand() % 0xFF) & op_nn_value(opcode);
+  vx_register(opcode) = (next_random() % 0xFF) & op_nn_value(opcode);
   return true;
 }
 
@@ -309,10 +778,13 @@ bool Emulator::handleOpcodeD(halfword opcode) {
   // * - Put both bytes back
   // In some cases, this would make us draw past the screen, so we skip those
   byte const num_rows = op_z_value(opcode);
+  if (debug_active) {
+    checkWatchpoints(index_register, num_rows, false);
+  }
   for (byte y = 0; y < num_rows; ++y) {
-    halfword const graphics_data = ram.at(index_register + y) << (8 - sprite_x_bits);
+    halfword const graphics_data = ram.get(index_register + y) << (8 - sprite_x_bits);
     byte const screen_pos = (sprite_x_bytes + ((sprite_y + y) * screen_columns));
-    bool const has_right_byte = screen_pos + 1 < screen_bytes;
+    bool const has_right_byte = screen_pos + 1U < screen_bytes;
 
     byte scratch_byte = 0;
     byte& screen_byte_left = screen.at(screen_pos % screen_bytes);
@@ -326,39 +798,51 @@ bool Emulator::handleOpcodeD(halfword opcode) {
 
     screen_byte_left = ((screen_data & 0xFF00) >> 8);
     screen_byte_right = (screen_data & 0x00FF);
-  }
 
-  if (onGraphics != nullptr) {
-    onGraphics();
+    if (debug_active) {
+      if (graphics_data & 0xFF00) {
+        recordScreenChange(screen_pos % screen_bytes);
+      }
+      if ((graphics_data & 0x00FF) && has_right_byte) {
+        recordScreenChange((screen_pos + 1) % screen_bytes);
+      }
+    }
   }
+  COUNT(sprite_rows += num_rows);
+  COUNT(collisions += vf_register());
+
+  ++runtime_counters.draws;
+  runtime_counters.collisions += vf_register();
+  notifyGraphics();
 
   return true;
 }
 
 bool Emulator::handleOpcodeE(halfword opcode) {
+  COUNT(keys[opcode & 0x00FF]++);
   switch (op_nn_value(opcode)) {
 
     // 0xEX9E - Skips the next instruction if the key stored in VX is pressed.
     case 0x009E:
-      if (keys_state.at(vx_register(opcode)) != 0) { increment_pc(); }
+      if (keys_state.at(vx_register(opcode)) != 0) { increment_pc(); COUNT(skips++); }
       return true;
 
     // 0xEXA1 - Skips the next instruction if the key stored in VX isn't pressed.
     case 0x00A1:
-      if (keys_state.at(vx_register(opcode)) == 0) { increment_pc(); }
+      if (keys_state.at(vx_register(opcode)) == 0) { increment_pc(); COUNT(skips++); }
       return true;
 
     default: {
       std::stringstream ss;
       ss << "Opcode " << std::hex << std::setw(4) << std::setfill('0')
          << opcode << " not implemented";
-      error_msg = ss.str();
-      return false;
+      return fault(FaultType::UnknownOpcode, ss.str());
     }
   }
 }
 
 bool Emulator::handleOpcodeF(halfword opcode) {
+  COUNT(misc[opcode & 0x00FF]++);
   switch (op_nn_value(opcode)) {
 
     // 0xFX07 - Sets VX to the value of the delay timer.
@@ -368,6 +852,7 @@ bool Emulator::handleOpcodeF(halfword opcode) {
     case 0x000A:
       awaiting_keypress = true;
       awaiting_keypress_register = op_x_value(opcode);
+      PROBE2(key_wait_start, program_counter, awaiting_keypress_register);
       return true;
 
     // 0xFX15 - Sets the delay timer to VX.
@@ -398,6 +883,11 @@ bool Emulator::handleOpcodeF(halfword opcode) {
     // location I+2.)
     case 0x0033: {
       byte value = vx_register(opcode);
+      if (debug_active) {
+        checkWatchpoints(index_register, 3, true);
+        recordRamWrite(index_register, 3);
+      }
+      markRamModified(index_register, 3);
       ram.at(index_register + 0) = value / 100;
       ram.at(index_register + 1) = value / 10 % 10;
       ram.at(index_register + 2) = value % 10;
@@ -408,6 +898,11 @@ bool Emulator::handleOpcodeF(halfword opcode) {
     // Also sets I to I + X + 1
     case 0x0055: {
       halfword end = op_x_value(opcode);
+      if (debug_active) {
+        checkWatchpoints(index_register, end + 1, true);
+        recordRamWrite(index_register, end + 1);
+      }
+      markRamModified(index_register, end + 1);
       for (halfword i = 0; i <= end; ++i) {
         ram.at(index_register++) = registers.at(i);
       }
@@ -418,8 +913,11 @@ bool Emulator::handleOpcodeF(halfword opcode) {
     // Also sets I to I + X + 1
     case 0x0065: {
       halfword end = op_x_value(opcode);
+      if (debug_active) {
+        checkWatchpoints(index_register, end + 1, false);
+      }
       for (halfword i = 0; i <= end; ++i) {
-        registers.at(i) = ram.at(index_register++);
+        registers.at(i) = ram.get(index_register++);
       }
       return true;
     }
@@ -428,13 +926,13 @@ bool Emulator::handleOpcodeF(halfword opcode) {
       std::stringstream ss;
       ss << "Opcode " << std::hex << std::setw(4) << std::setfill('0')
          << opcode << " not implemented";
-      error_msg = ss.str();
-      return false;
+      return fault(FaultType::UnknownOpcode, ss.str());
     }
   }
 }
 
 bool Emulator::handleOpcode(halfword opcode) {
+  COUNT(classes[opcode >> 12]++);
   switch (opcode & 0xF000) {
     case 0x0000: return handleOpcode0(opcode);
     case 0x1000: return handleOpcode1(opcode);
@@ -489,23 +987,48 @@ inline void Emulator::increment_pc() {
   program_counter = (program_counter + 2) % ram_size;
 }
 
+inline uint32_t Emulator::next_random() {
+  // xorshift32 - per instance, so no locking or shared state like rand()
+  rng_state ^= rng_state << 13;
+  rng_state ^= rng_state >> 17;
+  rng_state ^= rng_state << 5;
+  return rng_state;
+}
+
 
 bool Emulator::tick() {
+  ++runtime_counters.ticks;
   if (awaiting_keypress || tick_lock) {
+    runtime_counters.idle_ticks += awaiting_keypress;
+    return true;
+  }
+  if (debug_active && checkBreakpoint()) {
     return true;
   }
   tick_lock = true;
 
+  // A program counter out of bounds is reported as is, rather than as the
+  // invalid opcode fetchOpcode() returns for it
+  fault_type = FaultType::None;
   halfword opcode = fetchOpcode();
-  bool return_value = handleOpcode(opcode);
+  bool return_value = fault_type == FaultType::None && handleOpcode(opcode);
+  ++instruction_count;
+  if (return_value) {
+    ++runtime_counters.instructions;
+  } else {
+    ++runtime_counters.faults[static_cast<unsigned>(fault_type)];
+  }
 
   if (delay_timer > 0) {
-    --delay_timer;
+    if (--delay_timer == 0) {
+      ++runtime_counters.timer_underflows;
+    }
   }
 
   if (sound_timer > 0) {
-    if (--sound_timer == 0 && onSound != nullptr) {
-      onSound();
+    if (--sound_timer == 0) {
+      ++runtime_counters.timer_underflows;
+      notifySound();
     }
   }
 
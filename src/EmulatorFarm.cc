@@ -0,0 +1,277 @@
+#include <chrono>
+#include <exception>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "chip8core/EmulatorFarm.h"
+
+EmulatorFarm::StopCondition::StopCondition() :
+  max_frames(0),
+  stop_at_pc(false),
+  program_counter(0),
+  stop_at_screen_hash(false),
+  screen_hash(0)
+  {}
+
+EmulatorFarm::Result::Result() :
+  reason(StopReason::None),
+  frames(0),
+  ticks(0),
+  program_counter(Emulator::program_counter_start),
+  screen_hash(0),
+  error()
+  {}
+
+EmulatorFarm::Summary::Summary() :
+  instances(0),
+  frame_limit(0),
+  program_counter(0),
+  screen_hash(0),
+  errors(0),
+  frames(0),
+  ticks(0),
+  seconds(0)
+  {}
+
+EmulatorFarm::Instance::Instance(Emulator const& source,
+                                 StopCondition const& stop_condition) :
+  emulator(source),
+  stop(stop_condition),
+  result()
+  {}
+
+EmulatorFarm::EmulatorFarm(unsigned threads, unsigned frame_ticks, bool pin) :
+  num_threads(threads),
+  ticks_per_frame(frame_ticks > 0 ? frame_ticks : 1),
+  pin_threads(pin),
+  instances(),
+  queues(),
+  remaining(0),
+  error_msg()
+  {
+    if (num_threads == 0) {
+      num_threads = std::thread::hardware_concurrency();
+    }
+    if (num_threads == 0) {
+      num_threads = 1;
+    }
+}
+
+std::size_t EmulatorFarm::add(Emulator const& emulator,
+                              StopCondition const& stop) {
+  instances.emplace_back(emulator, stop);
+  return instances.size() - 1;
+}
+
+bool EmulatorFarm::addRom(std::string const& file, StopCondition const& stop,
+                          std::size_t* id) {
+  Emulator emulator;
+  if (!emulator.loadFileToRam(file)) {
+    error_msg = file + ": " + emulator.getError();
+    return false;
+  }
+
+  std::size_t const new_id = add(emulator, stop);
+  if (id != nullptr) {
+    *id = new_id;
+  }
+  return true;
+}
+
+bool EmulatorFarm::addRom(RomImage const& rom, StopCondition const& stop,
+                          std::size_t* id) {
+  Emulator emulator;
+  if (!emulator.loadRom(rom)) {
+    error_msg = emulator.getError();
+    return false;
+  }
+
+  std::size_t const new_id = add(emulator, stop);
+  if (id != nullptr) {
+    *id = new_id;
+  }
+  return true;
+}
+
+EmulatorFarm::Result const& EmulatorFarm::result(std::size_t id) const {
+  return instances.at(id).result;
+}
+
+Emulator const& EmulatorFarm::emulator(std::size_t id) const {
+  return instances.at(id).emulator;
+}
+
+std::size_t EmulatorFarm::size() const {
+  return instances.size();
+}
+
+std::string const& EmulatorFarm::getError() const {
+  return error_msg;
+}
+
+uint64_t EmulatorFarm::screenHash(Emulator const& emulator) {
+  byte const* data = emulator.getGraphicsData();
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned i = 0; i < Emulator::screen_bytes; ++i) {
+    hash = (hash ^ data[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+EmulatorFarm::Summary EmulatorFarm::run() {
+  // One queue per worker, jobs dealt out round robin
+  queues.clear();
+  for (unsigned i = 0; i < num_threads; ++i) {
+    queues.emplace_back(new WorkQueue);
+  }
+
+  std::size_t jobs = 0;
+  for (std::size_t i = 0; i < instances.size(); ++i) {
+    if (instances.at(i).result.reason == StopReason::None) {
+      queues.at(jobs++ % num_threads)->jobs.push_back(i);
+    }
+  }
+  remaining = jobs;
+
+  auto const start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> workers;
+  for (unsigned i = 0; i < num_threads; ++i) {
+    workers.emplace_back(&EmulatorFarm::work, this, i);
+
+#ifdef __linux__
+    unsigned const cores = std::thread::hardware_concurrency();
+    if (pin_threads && cores > 0) {
+      cpu_set_t cpu_set;
+      CPU_ZERO(&cpu_set);
+      CPU_SET(i % cores, &cpu_set);
+      // Pinning is only a hint, so failure is fine
+      pthread_setaffinity_np(workers.back().native_handle(),
+                             sizeof(cpu_set), &cpu_set);
+    }
+#endif
+  }
+
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  Summary summary;
+  summary.seconds = std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+  summary.instances = instances.size();
+
+  for (Instance const& instance : instances) {
+    Result const& result = instance.result;
+    summary.frames += result.frames;
+    summary.ticks += result.ticks;
+    switch (result.reason) {
+      case StopReason::FrameLimit:     ++summary.frame_limit; break;
+      case StopReason::ProgramCounter: ++summary.program_counter; break;
+      case StopReason::ScreenHash:     ++summary.screen_hash; break;
+      case StopReason::Error:          ++summary.errors; break;
+      case StopReason::None:           break;
+    }
+  }
+
+  return summary;
+}
+
+void EmulatorFarm::work(unsigned worker) {
+  WorkQueue& own_queue = *queues.at(worker);
+
+  while (remaining.load() > 0) {
+    std::size_t job;
+    if (!popJob(worker, job)) {
+      // Everything left is being run by other workers right now
+      std::this_thread::yield();
+      continue;
+    }
+
+    if (runQuantum(instances.at(job))) {
+      --remaining;
+    } else {
+      std::lock_guard<std::mutex> guard(own_queue.lock);
+      own_queue.jobs.push_back(job);
+    }
+  }
+}
+
+bool EmulatorFarm::popJob(unsigned worker, std::size_t& job) {
+  // Own jobs are taken from the front ...
+  {
+    WorkQueue& own_queue = *queues.at(worker);
+    std::lock_guard<std::mutex> guard(own_queue.lock);
+    if (!own_queue.jobs.empty()) {
+      job = own_queue.jobs.front();
+      own_queue.jobs.pop_front();
+      return true;
+    }
+  }
+
+  // ... and stolen jobs from the back
+  for (unsigned i = 1; i < num_threads; ++i) {
+    WorkQueue& victim = *queues.at((worker + i) % num_threads);
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if (!victim.jobs.empty()) {
+      job = victim.jobs.back();
+      victim.jobs.pop_back();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool EmulatorFarm::runQuantum(Instance& instance) {
+  Emulator& emulator = instance.emulator;
+  StopCondition const& stop = instance.stop;
+  Result& result = instance.result;
+
+  // A bad ROM can make tick() throw, which must not take the farm down
+  try {
+    for (unsigned i = 0; i < ticks_per_frame; ++i) {
+      ++result.ticks;
+      if (!emulator.tick()) {
+        result.reason = StopReason::Error;
+        result.error = emulator.getError();
+        break;
+      }
+
+      if (stop.stop_at_pc
+          && emulator.getProgramCounter() == stop.program_counter) {
+        result.reason = StopReason::ProgramCounter;
+        break;
+      }
+    }
+  } catch (std::exception const& e) {
+    result.reason = StopReason::Error;
+    result.error = e.what();
+  }
+
+  result.program_counter = emulator.getProgramCounter();
+  if (result.reason == StopReason::None) {
+    ++result.frames;
+    // Hashing the screen is only worth it every frame if it can stop us
+    if (stop.stop_at_screen_hash) {
+      result.screen_hash = screenHash(emulator);
+      if (result.screen_hash == stop.screen_hash) {
+        result.reason = StopReason::ScreenHash;
+        return true;
+      }
+    }
+    if (stop.max_frames != 0 && result.frames >= stop.max_frames) {
+      result.reason = StopReason::FrameLimit;
+    }
+  }
+
+  if (result.reason == StopReason::None) {
+    return false;
+  }
+  result.screen_hash = screenHash(emulator);
+  return true;
+}
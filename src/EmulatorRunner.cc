@@ -0,0 +1,125 @@
+#include <chrono>
+#include <cstring>
+#include <exception>
+
+#include "chip8core/EmulatorRunner.h"
+
+EmulatorRunner::EmulatorRunner(Emulator const& source,
+                               unsigned ticks_per_second,
+                               unsigned frames) :
+  emulator(source),
+  ticks_per_frame(1),
+  frames_per_second(frames > 0 ? frames : 1),
+  graphics_changed(false),
+  scratch_event(),
+  key_queue(),
+  event_queue(),
+  running(false),
+  dropped_events(0),
+  thread()
+  {
+    if (ticks_per_second > frames_per_second) {
+      ticks_per_frame = ticks_per_second / frames_per_second;
+    }
+
+    emulator.onGraphics = [this]() { graphics_changed = true; };
+    emulator.onSound = [this]() {
+      scratch_event.type = Event::Type::Sound;
+      publish(scratch_event);
+    };
+}
+
+EmulatorRunner::~EmulatorRunner() {
+  stop();
+}
+
+void EmulatorRunner::start() {
+  if (running) {
+    return;
+  }
+
+  // The thread may have stopped by itself after a fault
+  if (thread.joinable()) {
+    thread.join();
+  }
+  running = true;
+  thread = std::thread(&EmulatorRunner::run, this);
+}
+
+void EmulatorRunner::stop() {
+  running = false;
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+bool EmulatorRunner::isRunning() const {
+  return running;
+}
+
+bool EmulatorRunner::pushKey(int key_number, bool on) {
+  if (key_number < 0 || key_number >= static_cast<int>(Emulator::num_keys)) {
+    return false;
+  }
+  KeyEvent const event = { static_cast<byte>(key_number), on };
+  return key_queue.tryPush(event);
+}
+
+bool EmulatorRunner::pollEvent(Event& event) {
+  return event_queue.tryPop(event);
+}
+
+uint64_t EmulatorRunner::droppedEvents() const {
+  return dropped_events;
+}
+
+void EmulatorRunner::publish(Event const& event) {
+  if (!event_queue.tryPush(event)) {
+    ++dropped_events;
+  }
+}
+
+void EmulatorRunner::publishFault(char const* error) {
+  scratch_event.type = Event::Type::Fault;
+  strncpy(scratch_event.error, error, sizeof(scratch_event.error) - 1);
+  scratch_event.error[sizeof(scratch_event.error) - 1] = '\0';
+  publish(scratch_event);
+  running = false;
+}
+
+void EmulatorRunner::run() {
+  using clock = std::chrono::steady_clock;
+  clock::duration const frame_time =
+    std::chrono::duration_cast<clock::duration>(std::chrono::seconds(1))
+    / frames_per_second;
+  clock::time_point next_frame = clock::now();
+
+  while (running) {
+    KeyEvent key_event;
+    while (key_queue.tryPop(key_event)) {
+      emulator.setKeyState(key_event.key_number, key_event.on);
+    }
+
+    try {
+      for (unsigned i = 0; i < ticks_per_frame && running; ++i) {
+        if (!emulator.tick()) {
+          publishFault(emulator.getError().c_str());
+        }
+      }
+    } catch (std::exception const& e) {
+      publishFault(e.what());
+    }
+
+    // Draws are coalesced into one frame event
+    if (graphics_changed) {
+      graphics_changed = false;
+      scratch_event.type = Event::Type::Frame;
+      memcpy(scratch_event.screen, emulator.getGraphicsData(),
+             Emulator::screen_bytes);
+      publish(scratch_event);
+    }
+
+    next_frame += frame_time;
+    std::this_thread::sleep_until(next_frame);
+  }
+}
@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <fstream>
+
+#include "chip8core/ExecutionTracer.h"
+
+namespace {
+
+char const trace_magic[4] = { 'C', '8', 'T', 'R' };
+uint16_t constexpr trace_version = 1;
+
+void put(std::ostream& out, uint64_t value, unsigned bytes) {
+  for (unsigned i = 0; i < bytes; ++i) {
+    out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+uint64_t get(std::istream& in, unsigned bytes) {
+  uint64_t value = 0;
+  for (unsigned i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(in.get() & 0xFF) << (8 * i);
+  }
+  return value;
+}
+
+// Returns the register opcode writes its result to, or -1 if none
+int writtenRegister(halfword opcode) {
+  int const x = (opcode & 0x0F00) >> 8;
+  switch (opcode & 0xF000) {
+    case 0x6000: case 0x7000: case 0x8000: case 0xC000:
+      return x;
+    case 0xD000:
+      return 0xF;
+    case 0xF000:
+      switch (opcode & 0x00FF) {
+        case 0x07: case 0x65: return x;
+        default:              return -1;
+      }
+    default:
+      return -1;
+  }
+}
+
+std::size_t roundUpToPowerOfTwo(std::size_t value) {
+  std::size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+} // anonymous namespace
+
+uint64_t TraceRecord::pack() const {
+  return static_cast<uint64_t>(opcode)
+       | static_cast<uint64_t>(program_counter) << 16
+       | static_cast<uint64_t>(index_register) << 32
+       | static_cast<uint64_t>(register_value) << 48
+       | static_cast<uint64_t>(register_number & 0xF) << 56
+       | static_cast<uint64_t>(has_register) << 60
+       | static_cast<uint64_t>(fault) << 61;
+}
+
+TraceRecord TraceRecord::unpack(uint64_t packed) {
+  TraceRecord const record = {
+    static_cast<halfword>(packed >> 16),
+    static_cast<halfword>(packed),
+    static_cast<halfword>(packed >> 32),
+    ((packed >> 60) & 1) != 0,
+    static_cast<byte>((packed >> 56) & 0xF),
+    static_cast<byte>(packed >> 48),
+    ((packed >> 61) & 1) != 0
+  };
+  return record;
+}
+
+Trace::Trace() :
+  records(),
+  fault(),
+  error_msg()
+  {}
+
+std::string const& Trace::getError() const {
+  return error_msg;
+}
+
+bool Trace::save(std::string const& filename) {
+  std::ofstream file(filename, std::ios::binary);
+
+  file.write(trace_magic, sizeof(trace_magic));
+  put(file, trace_version, 2);
+  put(file, 0, 2);
+  put(file, records.size(), 4);
+  put(file, fault.size(), 4);
+  file.write(fault.data(), fault.size());
+  for (TraceRecord const& record : records) {
+    put(file, record.pack(), 8);
+  }
+
+  if (!file) {
+    error_msg = "Error writing to " + filename;
+    return false;
+  }
+  return true;
+}
+
+bool Trace::load(std::string const& filename) {
+  std::ifstream file(filename, std::ios::binary);
+  if (!file) {
+    error_msg = "File empty or not found";
+    return false;
+  }
+
+  char magic[sizeof(trace_magic)];
+  file.read(magic, sizeof(magic));
+  if (!file || memcmp(magic, trace_magic, sizeof(magic)) != 0) {
+    error_msg = "Not a trace";
+    return false;
+  }
+
+  uint64_t const version = get(file, 2);
+  if (version != trace_version) {
+    error_msg = "Unsupported trace version " + std::to_string(version);
+    return false;
+  }
+  get(file, 2);
+
+  uint64_t const num_records = get(file, 4);
+  uint64_t const fault_size = get(file, 4);
+  if (!file || fault_size > 0xFFFF) {
+    error_msg = "Corrupt trace";
+    return false;
+  }
+  std::string loaded_fault(fault_size, '\0');
+  file.read(&loaded_fault[0], loaded_fault.size());
+
+  std::vector<TraceRecord> loaded;
+  for (uint64_t i = 0; i < num_records && file; ++i) {
+    loaded.push_back(TraceRecord::unpack(get(file, 8)));
+  }
+
+  if (!file) {
+    error_msg = "Corrupt trace";
+    return false;
+  }
+
+  records.swap(loaded);
+  fault.swap(loaded_fault);
+  return true;
+}
+
+ExecutionTracer::ExecutionTracer(std::size_t capacity) :
+  ring(roundUpToPowerOfTwo(capacity > 0 ? capacity : 1)),
+  mask(ring.size() - 1),
+  head(0),
+  fault_file(),
+  spill_thread(),
+  spill_trace(),
+  spill_ok(true),
+  error_msg()
+  {}
+
+ExecutionTracer::~ExecutionTracer() {
+  waitForSpill();
+}
+
+void ExecutionTracer::append(TraceRecord const& record) {
+  uint64_t const position = head.load(std::memory_order_relaxed);
+  // Release, so a snapshot which copies this record also sees the head it
+  // was written at, and knows the record it replaced is gone
+  ring[position & mask].store(record.pack(), std::memory_order_release);
+  head.store(position + 1, std::memory_order_release);
+}
+
+bool ExecutionTracer::tick(Emulator& emulator) {
+  halfword const program_counter = emulator.getProgramCounter();
+  byte bytes[2] = { 0, 0 };
+  if (program_counter + 1U < Emulator::ram_size) {
+    emulator.readRam(program_counter, bytes, 2);
+  }
+  uint64_t const instructions = emulator.getInstructionCount();
+  halfword const opcode = (bytes[0] << 8) | bytes[1];
+
+  bool status;
+  try {
+    status = emulator.tick();
+  } catch (std::exception const& e) {
+    // Keep the post-mortem for instructions which throw, then pass it on
+    TraceRecord const record = {
+      program_counter, opcode, emulator.getIndexRegister(),
+      false, 0, 0, true
+    };
+    append(record);
+    if (!fault_file.empty()) {
+      spill(fault_file, e.what());
+    }
+    throw;
+  }
+  if (emulator.getInstructionCount() == instructions) {
+    return status;
+  }
+
+  int const written = writtenRegister(opcode);
+  TraceRecord const record = {
+    program_counter,
+    opcode,
+    emulator.getIndexRegister(),
+    written >= 0,
+    static_cast<byte>(written >= 0 ? written : 0),
+    written >= 0 ? emulator.getRegister(written) : byte(0),
+    !status
+  };
+  append(record);
+
+  if (!status && !fault_file.empty()) {
+    spill(fault_file, emulator.getError());
+  }
+  return status;
+}
+
+void ExecutionTracer::setFaultFile(std::string const& file) {
+  fault_file = file;
+}
+
+std::vector<TraceRecord> ExecutionTracer::snapshot() const {
+  uint64_t const capacity = ring.size();
+  uint64_t const end = head.load(std::memory_order_acquire);
+  uint64_t const start = end > capacity ? end - capacity : 0;
+
+  std::vector<uint64_t> copied;
+  copied.reserve(end - start);
+  for (uint64_t i = start; i < end; ++i) {
+    copied.push_back(ring[i & mask].load(std::memory_order_relaxed));
+  }
+
+  // Whatever the writer got to while copying may have been overwritten
+  std::atomic_thread_fence(std::memory_order_acquire);
+  // An append in progress has already overwritten record now - capacity
+  // before publishing now + 1
+  uint64_t const now = head.load(std::memory_order_relaxed);
+  uint64_t const valid = now + 1 > capacity ? now + 1 - capacity : 0;
+
+  std::vector<TraceRecord> records;
+  for (uint64_t i = std::max(start, valid); i < end; ++i) {
+    records.push_back(TraceRecord::unpack(copied[i - start]));
+  }
+  return records;
+}
+
+uint64_t ExecutionTracer::recorded() const {
+  return head.load(std::memory_order_relaxed);
+}
+
+void ExecutionTracer::spill(std::string const& file) {
+  spill(file, "");
+}
+
+void ExecutionTracer::spill(std::string const& file, std::string const& fault) {
+  waitForSpill();
+  spill_trace.records = snapshot();
+  spill_trace.fault = fault;
+  spill_thread = std::thread([this, file]() {
+    spill_ok = spill_trace.save(file);
+  });
+}
+
+bool ExecutionTracer::waitForSpill() {
+  if (spill_thread.joinable()) {
+    spill_thread.join();
+  }
+  if (!spill_ok) {
+    error_msg = spill_trace.getError();
+  }
+  return spill_ok;
+}
+
+std::string const& ExecutionTracer::getError() const {
+  return error_msg;
+}
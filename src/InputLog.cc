@@ -0,0 +1,232 @@
+#include <cstring>
+#include <fstream>
+
+#include "chip8core/InputLog.h"
+
+namespace {
+
+char const log_magic[4] = { 'C', '8', 'I', 'L' };
+uint16_t constexpr log_version = 1;
+
+void put(std::ostream& out, uint64_t value, unsigned bytes) {
+  for (unsigned i = 0; i < bytes; ++i) {
+    out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+  }
+}
+
+uint64_t get(std::istream& in, unsigned bytes) {
+  uint64_t value = 0;
+  for (unsigned i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(in.get() & 0xFF) << (8 * i);
+  }
+  return value;
+}
+
+} // anonymous namespace
+
+InputLog::InputLog() :
+  seed(0),
+  start_state(),
+  key_events(),
+  frame_hashes(),
+  error_msg()
+  {}
+
+std::string const& InputLog::getError() const {
+  return error_msg;
+}
+
+bool InputLog::save(std::string const& filename) {
+  std::ofstream file(filename, std::ios::binary);
+
+  file.write(log_magic, sizeof(log_magic));
+  put(file, log_version, 2);
+  put(file, seed, 4);
+  put(file, start_state.size(), 4);
+  file.write(reinterpret_cast<char const*>(start_state.data()), start_state.size());
+
+  put(file, key_events.size(), 4);
+  for (KeyEvent const& event : key_events) {
+    put(file, event.instruction, 8);
+    put(file, event.key_number, 1);
+    put(file, event.on, 1);
+  }
+
+  put(file, frame_hashes.size(), 4);
+  for (FrameHash const& frame : frame_hashes) {
+    put(file, frame.instruction, 8);
+    put(file, frame.events_before, 8);
+    put(file, frame.hash, 8);
+  }
+
+  if (!file) {
+    error_msg = "Error writing to " + filename;
+    return false;
+  }
+  return true;
+}
+
+bool InputLog::load(std::string const& filename) {
+  std::ifstream file(filename, std::ios::binary);
+  if (!file) {
+    error_msg = "File empty or not found";
+    return false;
+  }
+
+  char magic[sizeof(log_magic)];
+  file.read(magic, sizeof(magic));
+  if (!file || memcmp(magic, log_magic, sizeof(magic)) != 0) {
+    error_msg = "Not an input log";
+    return false;
+  }
+
+  uint64_t const version = get(file, 2);
+  if (version != log_version) {
+    error_msg = "Unsupported input log version " + std::to_string(version);
+    return false;
+  }
+
+  InputLog loaded;
+  loaded.seed = get(file, 4);
+  uint64_t const state_size = get(file, 4);
+  if (state_size != Emulator::state_size) {
+    error_msg = "Corrupt input log";
+    return false;
+  }
+  loaded.start_state.resize(state_size);
+  file.read(reinterpret_cast<char*>(loaded.start_state.data()), state_size);
+
+  uint64_t const num_events = get(file, 4);
+  for (uint64_t i = 0; i < num_events && file; ++i) {
+    KeyEvent event;
+    event.instruction = get(file, 8);
+    event.key_number = get(file, 1);
+    event.on = get(file, 1) != 0;
+    loaded.key_events.push_back(event);
+  }
+
+  uint64_t const num_hashes = get(file, 4);
+  for (uint64_t i = 0; i < num_hashes && file; ++i) {
+    FrameHash frame;
+    frame.instruction = get(file, 8);
+    frame.events_before = get(file, 8);
+    frame.hash = get(file, 8);
+    loaded.frame_hashes.push_back(frame);
+  }
+
+  if (!file) {
+    error_msg = "Corrupt input log";
+    return false;
+  }
+
+  seed = loaded.seed;
+  start_state.swap(loaded.start_state);
+  key_events.swap(loaded.key_events);
+  frame_hashes.swap(loaded.frame_hashes);
+  return true;
+}
+
+InputRecorder::InputRecorder(Emulator& target, uint32_t seed) :
+  emulator(target),
+  start_instruction(target.getInstructionCount()),
+  input_log(),
+  scratch(Emulator::state_size)
+  {
+    emulator.setSeed(seed);
+    input_log.seed = seed;
+    input_log.start_state = emulator.saveState();
+}
+
+void InputRecorder::setKeyState(int key_number, bool on) {
+  emulator.setKeyState(key_number, on);
+
+  InputLog::KeyEvent const event = {
+    emulator.getInstructionCount() - start_instruction,
+    static_cast<byte>(key_number), on
+  };
+  input_log.key_events.push_back(event);
+}
+
+void InputRecorder::markFrame() {
+  InputLog::FrameHash const frame = {
+    emulator.getInstructionCount() - start_instruction,
+    input_log.key_events.size(),
+    stateHash(emulator, scratch.data())
+  };
+  input_log.frame_hashes.push_back(frame);
+}
+
+InputLog const& InputRecorder::log() const {
+  return input_log;
+}
+
+uint64_t InputRecorder::stateHash(Emulator const& emulator, byte* scratch) {
+  std::size_t const size = emulator.saveState(scratch, Emulator::state_size);
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (std::size_t i = 0; i < size; ++i) {
+    hash = (hash ^ scratch[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+InputReplayer::InputReplayer(Emulator& target, InputLog const& log) :
+  emulator(target),
+  input_log(log),
+  start_instruction(target.getInstructionCount()),
+  next_event(0),
+  next_hash(0),
+  scratch(Emulator::state_size),
+  error_msg()
+  {
+    if (!emulator.loadState(log.start_state.data(), log.start_state.size())) {
+      error_msg = emulator.getError();
+    }
+}
+
+bool InputReplayer::replayDue() {
+  uint64_t const now = emulator.getInstructionCount() - start_instruction;
+  std::vector<InputLog::KeyEvent> const& events = input_log.key_events;
+  std::vector<InputLog::FrameHash> const& hashes = input_log.frame_hashes;
+
+  // Events and hashes are replayed in the order they were recorded
+  for (;;) {
+    if (next_hash < hashes.size()
+        && hashes.at(next_hash).instruction <= now
+        && hashes.at(next_hash).events_before <= next_event) {
+      if (InputRecorder::stateHash(emulator, scratch.data()) != hashes.at(next_hash).hash) {
+        error_msg = "Replay diverged at instruction " + std::to_string(now);
+        return false;
+      }
+      ++next_hash;
+
+    } else if (next_event < events.size() && events.at(next_event).instruction <= now) {
+      emulator.setKeyState(events.at(next_event).key_number, events.at(next_event).on);
+      ++next_event;
+
+    } else {
+      return true;
+    }
+  }
+}
+
+bool InputReplayer::tick() {
+  if (!error_msg.empty() || !replayDue()) {
+    return false;
+  }
+
+  if (!emulator.tick()) {
+    error_msg = emulator.getError();
+    return false;
+  }
+
+  return replayDue();
+}
+
+bool InputReplayer::finished() const {
+  return next_event == input_log.key_events.size()
+      && next_hash == input_log.frame_hashes.size();
+}
+
+std::string const& InputReplayer::getError() const {
+  return error_msg;
+}
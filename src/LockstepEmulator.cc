@@ -0,0 +1,618 @@
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "chip8core/LockstepEmulator.h"
+
+unsigned constexpr LockstepEmulator::max_lanes;
+
+namespace {
+
+unsigned constexpr ram_size       = Emulator::ram_size;
+unsigned constexpr num_registers  = Emulator::num_registers;
+unsigned constexpr screen_columns = Emulator::screen_columns;
+unsigned constexpr screen_bytes   = Emulator::screen_bytes;
+unsigned constexpr stack_size     = Emulator::stack_size;
+unsigned constexpr num_keys       = Emulator::num_keys;
+
+inline halfword op_x_value(halfword opcode)   { return (opcode & 0x0F00) >> 8; }
+inline halfword op_y_value(halfword opcode)   { return (opcode & 0x00F0) >> 4; }
+inline halfword op_z_value(halfword opcode)   { return opcode & 0x000F; }
+inline halfword op_nnn_value(halfword opcode) { return opcode & 0x0FFF; }
+inline halfword op_nn_value(halfword opcode)  { return opcode & 0x00FF; }
+
+inline bool in_mask(uint32_t mask, unsigned lane) {
+  return (mask >> lane) & 1U;
+}
+
+} // anonymous namespace
+
+LockstepEmulator::LockstepEmulator(unsigned lanes, unsigned limit) :
+  onSound(nullptr),
+  onGraphics(nullptr),
+  num_lanes(std::min(std::max(lanes, 1U), max_lanes)),
+  divergence_limit(limit != 0 ? limit : std::max(num_lanes / 4, 1U)),
+  ram(ram_size * num_lanes, 0),
+  screen(screen_bytes * num_lanes, 0),
+  registers(num_registers * num_lanes, 0),
+  index_register(num_lanes, 0),
+  program_counter(num_lanes, Emulator::program_counter_start),
+  sound_timer(num_lanes, 0),
+  delay_timer(num_lanes, 0),
+  stack(stack_size * num_lanes, 0),
+  stack_pointer(num_lanes, 0),
+  keys_state(num_keys * num_lanes, 0),
+  awaiting_keypress(num_lanes, 0),
+  awaiting_keypress_register(num_lanes, 0),
+  rng_state(num_lanes, 0),
+  error_msg(num_lanes),
+  opcodes(num_lanes, 0),
+  failed_lanes(0),
+  group_count(0)
+  {
+    Emulator const fresh;
+    for (unsigned lane = 0; lane < num_lanes; ++lane) {
+      setLane(lane, fresh);
+    }
+}
+
+unsigned LockstepEmulator::lanes() const {
+  return num_lanes;
+}
+
+void LockstepEmulator::setLane(unsigned lane, Emulator const& emulator) {
+  if (lane >= num_lanes) {
+    throw std::out_of_range("LockstepEmulator: lane out of range");
+  }
+
+  emulator.ram.read(0, &ram.at(lane * ram_size), ram_size);
+  memcpy(&screen.at(lane * screen_bytes), emulator.screen.data(), screen_bytes);
+  for (unsigned i = 0; i < num_registers; ++i) {
+    registers.at(i * num_lanes + lane) = emulator.registers.at(i);
+  }
+  for (unsigned i = 0; i < stack_size; ++i) {
+    stack.at(i * num_lanes + lane) = emulator.stack.at(i);
+  }
+  for (unsigned i = 0; i < num_keys; ++i) {
+    keys_state.at(i * num_lanes + lane) = emulator.keys_state.at(i);
+  }
+  index_register.at(lane)             = emulator.index_register;
+  program_counter.at(lane)            = emulator.program_counter;
+  sound_timer.at(lane)                = emulator.sound_timer;
+  delay_timer.at(lane)                = emulator.delay_timer;
+  stack_pointer.at(lane)              = emulator.stack_pointer;
+  awaiting_keypress.at(lane)          = emulator.awaiting_keypress;
+  awaiting_keypress_register.at(lane) = emulator.awaiting_keypress_register;
+  rng_state.at(lane)                  = emulator.rng_state;
+  error_msg.at(lane)                  = emulator.error_msg;
+}
+
+void LockstepEmulator::getLane(unsigned lane, Emulator& emulator) const {
+  if (lane >= num_lanes) {
+    throw std::out_of_range("LockstepEmulator: lane out of range");
+  }
+
+  emulator.ram.write(0, &ram.at(lane * ram_size), ram_size);
+  emulator.updateModifiedPages();
+  memcpy(emulator.screen.data(), &screen.at(lane * screen_bytes), screen_bytes);
+  for (unsigned i = 0; i < num_registers; ++i) {
+    emulator.registers.at(i) = registers.at(i * num_lanes + lane);
+  }
+  for (unsigned i = 0; i < stack_size; ++i) {
+    emulator.stack.at(i) = stack.at(i * num_lanes + lane);
+  }
+  for (unsigned i = 0; i < num_keys; ++i) {
+    emulator.keys_state.at(i) = keys_state.at(i * num_lanes + lane);
+  }
+  emulator.index_register             = index_register.at(lane);
+  emulator.program_counter            = program_counter.at(lane);
+  emulator.sound_timer                = sound_timer.at(lane);
+  emulator.delay_timer                = delay_timer.at(lane);
+  emulator.stack_pointer              = stack_pointer.at(lane);
+  emulator.awaiting_keypress          = awaiting_keypress.at(lane);
+  emulator.awaiting_keypress_register = awaiting_keypress_register.at(lane);
+  emulator.rng_state                  = rng_state.at(lane);
+  emulator.error_msg                  = error_msg.at(lane);
+}
+
+bool LockstepEmulator::loadFileToRam(std::string const& file) {
+  Emulator emulator;
+  bool const status = emulator.loadFileToRam(file);
+
+  for (unsigned lane = 0; lane < num_lanes; ++lane) {
+    if (status) {
+      setLane(lane, emulator);
+    } else {
+      error_msg.at(lane) = emulator.getError();
+    }
+  }
+  return status;
+}
+
+void LockstepEmulator::setKeyState(unsigned lane, int key_number, bool on) {
+  keyAt(lane, key_number) = on ? 0xFF : 0x00;
+
+  if (awaiting_keypress.at(lane)) {
+    reg(lane, awaiting_keypress_register.at(lane)) = key_number;
+    awaiting_keypress.at(lane) = false;
+  }
+}
+
+void LockstepEmulator::setSeed(unsigned lane, uint32_t seed) {
+  rng_state.at(lane) = seed != 0 ? seed : 0x2545F491U;
+}
+
+uint32_t LockstepEmulator::failedLanes() const {
+  return failed_lanes;
+}
+
+std::string const& LockstepEmulator::getError(unsigned lane) const {
+  return error_msg.at(lane);
+}
+
+byte const* LockstepEmulator::getGraphicsData(unsigned lane) const {
+  return &screen.at(lane * screen_bytes);
+}
+
+halfword LockstepEmulator::getProgramCounter(unsigned lane) const {
+  return program_counter.at(lane);
+}
+
+uint64_t LockstepEmulator::getGroupCount() const {
+  return group_count;
+}
+
+inline byte& LockstepEmulator::reg(unsigned lane, unsigned number) {
+  return registers[number * num_lanes + lane];
+}
+
+inline byte& LockstepEmulator::ramAt(unsigned lane, unsigned address) {
+  // Mirrors the bounds checking of Emulator, which uses std::vector::at()
+  if (address >= ram_size) {
+    throw std::out_of_range("LockstepEmulator: RAM address out of range");
+  }
+  return ram[lane * ram_size + address];
+}
+
+inline byte& LockstepEmulator::keyAt(unsigned lane, unsigned key) {
+  if (key >= num_keys) {
+    throw std::out_of_range("LockstepEmulator: key out of range");
+  }
+  return keys_state[key * num_lanes + lane];
+}
+
+void LockstepEmulator::fail(unsigned lane, std::string const& error) {
+  error_msg.at(lane) = error;
+  failed_lanes |= 1U << lane;
+}
+
+void LockstepEmulator::notImplemented(uint32_t mask, halfword opcode) {
+  std::stringstream ss;
+  ss << "Opcode " << std::hex << std::setw(4) << std::setfill('0')
+     << opcode << " not implemented";
+  for (unsigned lane = 0; lane < num_lanes; ++lane) {
+    if (in_mask(mask, lane)) { fail(lane, ss.str()); }
+  }
+}
+
+bool LockstepEmulator::tick() {
+  failed_lanes = 0;
+
+  // Fetch. A lane with its program counter out of bounds fails here, like
+  // Emulator::tick(), and only has its timers ticked
+  uint32_t pending = 0;
+  uint32_t ticked = 0;
+  for (unsigned lane = 0; lane < num_lanes; ++lane) {
+    if (awaiting_keypress[lane]) {
+      continue;
+    }
+    ticked |= 1U << lane;
+
+    halfword& pc = program_counter[lane];
+    if (pc >= ram_size - 1) {
+      fail(lane, "Program counter out of bounds");
+      continue;
+    }
+    pending |= 1U << lane;
+    opcodes[lane] = (ram[lane * ram_size + pc] << 8)
+                  + ram[lane * ram_size + pc + 1];
+    pc = (pc + 2) % ram_size;
+  }
+
+  // Execute, one group of lanes with the same address and opcode at a time
+  unsigned groups = 0;
+  while (pending != 0) {
+    unsigned const leader = __builtin_ctz(pending);
+    uint32_t mask = 1U << leader;
+
+    if (groups < divergence_limit) {
+      for (unsigned lane = leader + 1; lane < num_lanes; ++lane) {
+        if (in_mask(pending, lane)
+            && opcodes[lane] == opcodes[leader]
+            && program_counter[lane] == program_counter[leader]) {
+          mask |= 1U << lane;
+        }
+      }
+    }
+
+    executeGroup(mask, opcodes[leader]);
+    pending &= ~mask;
+    ++groups;
+  }
+  group_count += groups;
+
+  // Timers
+  for (unsigned lane = 0; lane < num_lanes; ++lane) {
+    if (!in_mask(ticked, lane)) {
+      continue;
+    }
+
+    if (delay_timer[lane] > 0) {
+      --delay_timer[lane];
+    }
+
+    if (sound_timer[lane] > 0) {
+      if (--sound_timer[lane] == 0 && onSound != nullptr) {
+        onSound(lane);
+      }
+    }
+  }
+
+  return failed_lanes == 0;
+}
+
+void LockstepEmulator::executeGroup(uint32_t mask, halfword opcode) {
+  halfword const x   = op_x_value(opcode);
+  halfword const y   = op_y_value(opcode);
+  halfword const nn  = op_nn_value(opcode);
+  halfword const nnn = op_nnn_value(opcode);
+
+  // Register rows, so the simple cases below are plain loops over lanes
+  byte* const vx = &registers[x * num_lanes];
+  byte* const vy = &registers[y * num_lanes];
+
+  switch (opcode & 0xF000) {
+    case 0x0000: executeOpcode0(mask, opcode); break;
+
+    // 0x1NNN - Jump to opcode & 0x0FFF
+    case 0x1000:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (in_mask(mask, lane)) { program_counter[lane] = nnn; }
+      }
+      break;
+
+    // 0x2NNN - Call subroutine at opcode & 0x0FFF
+    case 0x2000:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (!in_mask(mask, lane)) { continue; }
+        if (stack_pointer[lane] >= stack_size) {
+          fail(lane, "Stack overflow");
+          continue;
+        }
+        stack[stack_pointer[lane]++ * num_lanes + lane] = program_counter[lane];
+        program_counter[lane] = nnn;
+      }
+      break;
+
+    // 0x3XNN - Skips the next instruction if VX equals NN.
+    case 0x3000:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (in_mask(mask, lane) && vx[lane] == nn) {
+          program_counter[lane] = (program_counter[lane] + 2) % ram_size;
+        }
+      }
+      break;
+
+    // 0x4XNN - Skips the next instruction if VX doesn't equal NN.
+    case 0x4000:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (in_mask(mask, lane) && vx[lane] != nn) {
+          program_counter[lane] = (program_counter[lane] + 2) % ram_size;
+        }
+      }
+      break;
+
+    // 0x5XY0 - Skips the next instruction if VX equals VY
+    case 0x5000:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (in_mask(mask, lane) && vx[lane] == vy[lane]) {
+          program_counter[lane] = (program_counter[lane] + 2) % ram_size;
+        }
+      }
+      break;
+
+    // 0x6XNN - Set VX to NN
+    case 0x6000:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        vx[lane] = in_mask(mask, lane) ? nn : vx[lane];
+      }
+      break;
+
+    // 0x7XNN - Add NN to VX
+    case 0x7000:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        vx[lane] += in_mask(mask, lane) ? nn : 0;
+      }
+      break;
+
+    case 0x8000: executeOpcode8(mask, opcode); break;
+
+    // 0x9XY0 - Skips the next instruction if VX doesn't equal VY.
+    case 0x9000:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (in_mask(mask, lane) && vx[lane] != vy[lane]) {
+          program_counter[lane] = (program_counter[lane] + 2) % ram_size;
+        }
+      }
+      break;
+
+    // 0xANNN - Sets I to the address NNN.
+    case 0xA000:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        index_register[lane] = in_mask(mask, lane) ? nnn : index_register[lane];
+      }
+      break;
+
+    // 0xBNNN - Jumps to the address NNN plus V[0].
+    case 0xB000:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (in_mask(mask, lane)) {
+          program_counter[lane] = (nnn + registers[lane]) % 0x1000;
+        }
+      }
+      break;
+
+    // 0xCXNN - Sets VX to a bitwise and operation on a random number and NN.
+    case 0xC000:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (!in_mask(mask, lane)) { continue; }
+        uint32_t& rng = rng_state[lane];
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        vx[lane] = (rng % 0xFF) & nn;
+      }
+      break;
+
+    case 0xD000: executeOpcodeD(mask, opcode); break;
+    case 0xE000: executeOpcodeE(mask, opcode); break;
+    case 0xF000: executeOpcodeF(mask, opcode); break;
+  }
+}
+
+void LockstepEmulator::executeOpcode0(uint32_t mask, halfword opcode) {
+  switch (opcode) {
+
+    // 0x00E0 - Clears the screen
+    case 0x00E0:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (!in_mask(mask, lane)) { continue; }
+        memset(&screen[lane * screen_bytes], 0, screen_bytes);
+        if (onGraphics != nullptr) { onGraphics(lane); }
+      }
+      return;
+
+    // 0x00EE - Returns from subroutine
+    case 0x00EE:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (!in_mask(mask, lane)) { continue; }
+        if (stack_pointer[lane] == 0) {
+          fail(lane, "Stack underflow");
+          continue;
+        }
+        program_counter[lane] = stack[--stack_pointer[lane] * num_lanes + lane];
+      }
+      return;
+
+    // 0x0NNN - Calls RCA 1802 program at address NNN.
+    default:
+      notImplemented(mask, opcode);
+      return;
+  }
+}
+
+void LockstepEmulator::executeOpcode8(uint32_t mask, halfword opcode) {
+  halfword const x = op_x_value(opcode);
+  halfword const y = op_y_value(opcode);
+
+  // Same operations as Emulator::handleOpcode8, including the aliasing
+  // behaviour when X, Y or F are the same register
+  for (unsigned lane = 0; lane < num_lanes; ++lane) {
+    if (!in_mask(mask, lane)) { continue; }
+    byte& vx = reg(lane, x);
+    byte& vy = reg(lane, y);
+    byte& vf = reg(lane, 0xF);
+
+    switch (op_z_value(opcode)) {
+      case 0x0000: vx = vy; break;
+      case 0x0001: vx |= vy; break;
+      case 0x0002: vx &= vy; break;
+      case 0x0003: vx ^= vy; break;
+
+      case 0x0004: {
+        byte old_value = vx;
+        vx += vy;
+        vf = old_value > vx;
+        break;
+      }
+
+      case 0x0005: {
+        byte old_value = vx;
+        vx -= vy;
+        vf = old_value >= vx;
+        break;
+      }
+
+      case 0x0006:
+        vf = vy & 1;
+        vx = vy >>= 1;
+        break;
+
+      case 0x0007:
+        vx = vy - vx;
+        vf = vy >= vx;
+        break;
+
+      case 0x000E:
+        vf = vy & 0x80 ? 1 : 0;
+        vx = vy <<= 1;
+        break;
+
+      default:
+        notImplemented(mask, opcode);
+        return;
+    }
+  }
+}
+
+void LockstepEmulator::executeOpcodeD(uint32_t mask, halfword opcode) {
+  // 0xDXYN - See Emulator::handleOpcodeD
+  byte const num_rows = op_z_value(opcode);
+
+  for (unsigned lane = 0; lane < num_lanes; ++lane) {
+    if (!in_mask(mask, lane)) { continue; }
+
+    byte const sprite_x       = reg(lane, op_x_value(opcode));
+    byte const sprite_y       = reg(lane, op_y_value(opcode));
+    byte const sprite_x_bytes = sprite_x / 8;
+    byte const sprite_x_bits  = sprite_x % 8;
+    screen_row* const lane_screen = &screen[lane * screen_bytes];
+
+    reg(lane, 0xF) = 0;
+
+    for (byte y = 0; y < num_rows; ++y) {
+      halfword const graphics_data =
+        ramAt(lane, index_register[lane] + y) << (8 - sprite_x_bits);
+      byte const screen_pos = (sprite_x_bytes + ((sprite_y + y) * screen_columns));
+      bool const has_right_byte = screen_pos + 1U < screen_bytes;
+
+      byte scratch_byte = 0;
+      byte& screen_byte_left = lane_screen[screen_pos % screen_bytes];
+      byte& screen_byte_right = has_right_byte
+        ? lane_screen[(screen_pos + 1) % screen_bytes]
+        : scratch_byte;
+
+      halfword screen_data = (screen_byte_left << 8) + screen_byte_right;
+      if (screen_data & graphics_data) { reg(lane, 0xF) = 1; }
+      screen_data ^= graphics_data;
+
+      screen_byte_left = ((screen_data & 0xFF00) >> 8);
+      screen_byte_right = (screen_data & 0x00FF);
+    }
+
+    if (onGraphics != nullptr) {
+      onGraphics(lane);
+    }
+  }
+}
+
+void LockstepEmulator::executeOpcodeE(uint32_t mask, halfword opcode) {
+  halfword const x = op_x_value(opcode);
+
+  switch (op_nn_value(opcode)) {
+
+    // 0xEX9E - Skips the next instruction if the key stored in VX is pressed.
+    case 0x009E:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (in_mask(mask, lane) && keyAt(lane, reg(lane, x)) != 0) {
+          program_counter[lane] = (program_counter[lane] + 2) % ram_size;
+        }
+      }
+      return;
+
+    // 0xEXA1 - Skips the next instruction if the key stored in VX isn't pressed.
+    case 0x00A1:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (in_mask(mask, lane) && keyAt(lane, reg(lane, x)) == 0) {
+          program_counter[lane] = (program_counter[lane] + 2) % ram_size;
+        }
+      }
+      return;
+
+    default:
+      notImplemented(mask, opcode);
+      return;
+  }
+}
+
+void LockstepEmulator::executeOpcodeF(uint32_t mask, halfword opcode) {
+  halfword const x = op_x_value(opcode);
+  byte* const vx = &registers[x * num_lanes];
+
+  switch (op_nn_value(opcode)) {
+    case 0x0007:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        vx[lane] = in_mask(mask, lane) ? delay_timer[lane] : vx[lane];
+      }
+      return;
+
+    case 0x000A:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (!in_mask(mask, lane)) { continue; }
+        awaiting_keypress[lane] = true;
+        awaiting_keypress_register[lane] = x;
+      }
+      return;
+
+    case 0x0015:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        delay_timer[lane] = in_mask(mask, lane) ? vx[lane] : delay_timer[lane];
+      }
+      return;
+
+    case 0x0018:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        sound_timer[lane] = in_mask(mask, lane) ? vx[lane] : sound_timer[lane];
+      }
+      return;
+
+    case 0x001E:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (!in_mask(mask, lane)) { continue; }
+        byte old_index = index_register[lane];
+        index_register[lane] = (index_register[lane] + vx[lane]) % 0x1000;
+        reg(lane, 0xF) = old_index > index_register[lane];
+      }
+      return;
+
+    case 0x0029:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (in_mask(mask, lane)) { index_register[lane] = vx[lane] * 5; }
+      }
+      return;
+
+    case 0x0033:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (!in_mask(mask, lane)) { continue; }
+        byte value = vx[lane];
+        ramAt(lane, index_register[lane] + 0) = value / 100;
+        ramAt(lane, index_register[lane] + 1) = value / 10 % 10;
+        ramAt(lane, index_register[lane] + 2) = value % 10;
+      }
+      return;
+
+    case 0x0055:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (!in_mask(mask, lane)) { continue; }
+        for (halfword i = 0; i <= x; ++i) {
+          ramAt(lane, index_register[lane]++) = reg(lane, i);
+        }
+      }
+      return;
+
+    case 0x0065:
+      for (unsigned lane = 0; lane < num_lanes; ++lane) {
+        if (!in_mask(mask, lane)) { continue; }
+        for (halfword i = 0; i <= x; ++i) {
+          reg(lane, i) = ramAt(lane, index_register[lane]++);
+        }
+      }
+      return;
+
+    default:
+      notImplemented(mask, opcode);
+      return;
+  }
+}
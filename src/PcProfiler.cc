@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+#include "chip8core/Disassembler.h"
+#include "chip8core/PcProfiler.h"
+
+PcProfiler::PcProfiler(unsigned interval) :
+  sample_interval(interval > 0 ? interval : 1),
+  last_sample(-static_cast<uint64_t>(sample_interval)),
+  total_samples(0),
+  histogram()
+  {}
+
+void PcProfiler::record(Emulator const& emulator) {
+  ++histogram[emulator.getProgramCounter() & (Emulator::ram_size - 1)];
+  ++total_samples;
+  last_sample = emulator.getInstructionCount();
+}
+
+bool PcProfiler::tick(Emulator& emulator) {
+  bool const status = emulator.tick();
+  sample(emulator);
+  return status;
+}
+
+void PcProfiler::merge(PcProfiler const& other) {
+  for (std::size_t i = 0; i < histogram.size(); ++i) {
+    histogram[i] += other.histogram[i];
+  }
+  total_samples += other.total_samples;
+}
+
+void PcProfiler::reset() {
+  histogram.fill(0);
+  total_samples = 0;
+  last_sample = -static_cast<uint64_t>(sample_interval);
+}
+
+uint64_t PcProfiler::count(halfword address) const {
+  return histogram.at(address);
+}
+
+uint64_t PcProfiler::total() const {
+  return total_samples;
+}
+
+void PcProfiler::report(std::ostream& out, Emulator const& emulator,
+                        std::size_t max_lines) const {
+  std::vector<halfword> hot;
+  for (std::size_t address = 0; address < histogram.size(); ++address) {
+    if (histogram[address] > 0) {
+      hot.push_back(address);
+    }
+  }
+  std::stable_sort(hot.begin(), hot.end(), [this](halfword lhs, halfword rhs) {
+    return histogram[lhs] > histogram[rhs];
+  });
+  hot.resize(std::min(hot.size(), max_lines));
+
+  std::ios::fmtflags const flags = out.flags();
+  out << std::dec << "Samples: " << total_samples << " (every "
+      << sample_interval << " instructions)\n";
+
+  for (halfword address : hot) {
+    byte bytes[2] = { 0, 0 };
+    emulator.readRam(address, bytes, address + 1U < Emulator::ram_size ? 2 : 1);
+
+    double const share = 100.0 * histogram[address] / total_samples;
+    out << std::dec << std::setw(12) << histogram[address] << "  "
+        << std::fixed << std::setprecision(1) << std::setw(5) << share << "%  ";
+    describeOpcode(out, address, (bytes[0] << 8) | bytes[1]);
+  }
+  out.flags(flags);
+}
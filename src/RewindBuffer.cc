@@ -0,0 +1,237 @@
+#include <algorithm>
+#include <cstring>
+
+#include "chip8core/RewindBuffer.h"
+
+namespace {
+
+// Worst case size of an encoded state, see RewindBuffer::encode
+std::size_t constexpr max_encoded_size = Emulator::state_size * 2 + 16;
+
+// Zero runs shorter than this are cheaper to keep as literals
+unsigned constexpr min_zero_run = 4;
+
+// Share of the memory limit set aside for the frame index. An unchanged
+// frame encodes to a few bytes, so without a cap on the number of frames
+// the index would outgrow the ring.
+std::size_t constexpr index_share = 8;
+
+inline byte* put16(byte* out, uint16_t value) {
+  out[0] = value & 0xFF;
+  out[1] = value >> 8;
+  return out + 2;
+}
+
+inline uint16_t get16(byte const* in) {
+  return in[0] | (in[1] << 8);
+}
+
+} // anonymous namespace
+
+RewindBuffer::RewindBuffer(std::size_t memory_limit, unsigned interval) :
+  max_frames(std::max<std::size_t>(memory_limit / index_share / sizeof(Frame),
+                                   2)),
+  capacity(std::max(memory_limit - std::min(memory_limit,
+                                            max_frames * sizeof(Frame)),
+                    2 * max_encoded_size)),
+  keyframe_interval(interval > 0 ? interval : 1),
+  ring(capacity),
+  write_pos(0),
+  used(0),
+  frames(),
+  next_sequence(0),
+  current_keyframe(0),
+  have_keyframe(false),
+  since_keyframe(0),
+  state(Emulator::state_size),
+  keyframe_state(Emulator::state_size),
+  encoded(max_encoded_size),
+  error_msg()
+  {}
+
+std::size_t RewindBuffer::size() const {
+  return frames.size();
+}
+
+std::size_t RewindBuffer::memoryUsed() const {
+  return used + frames.size() * sizeof(Frame);
+}
+
+std::string const& RewindBuffer::getError() const {
+  return error_msg;
+}
+
+std::size_t RewindBuffer::encode(byte const* data, byte const* base) {
+  // Encodes data XOR base (or just data, if base is null) as a list of
+  // [zero run length][literal length][literal bytes]
+  byte* out = encoded.data();
+  std::size_t i = 0;
+  std::size_t const size = Emulator::state_size;
+
+  auto value = [&](std::size_t pos) -> byte {
+    return base != nullptr ? data[pos] ^ base[pos] : data[pos];
+  };
+
+  while (i < size) {
+    std::size_t zeros = 0;
+    while (i + zeros < size && zeros < 0xFFFF && value(i + zeros) == 0) {
+      ++zeros;
+    }
+    i += zeros;
+
+    std::size_t literals = 0;
+    while (i + literals < size && literals < 0xFFFF) {
+      // Stop at the first zero run long enough to be worth it
+      std::size_t run = 0;
+      while (run < min_zero_run && i + literals + run < size
+             && value(i + literals + run) == 0) {
+        ++run;
+      }
+      if (run == min_zero_run || i + literals + run == size) {
+        break;
+      }
+      literals += run + 1;
+    }
+    literals = std::min(literals, size - i);
+
+    out = put16(out, zeros);
+    out = put16(out, literals);
+    for (std::size_t j = 0; j < literals; ++j) {
+      *out++ = value(i + j);
+    }
+    i += literals;
+  }
+
+  return out - encoded.data();
+}
+
+void RewindBuffer::decode(Frame const& frame, byte* data) const {
+  // XORs the frame onto data
+  byte const* in = &ring.at(frame.offset);
+  byte const* const end = in + frame.length;
+  std::size_t pos = 0;
+
+  while (in < end) {
+    pos += get16(in);
+    std::size_t const literals = get16(in + 2);
+    in += 4;
+    for (std::size_t j = 0; j < literals; ++j) {
+      data[pos++] ^= *in++;
+    }
+  }
+}
+
+void RewindBuffer::dropOldest() {
+  used -= frames.front().length;
+  frames.pop_front();
+
+  // Deltas are useless without their keyframe
+  while (!frames.empty() && frames.front().keyframe != frames.front().sequence) {
+    used -= frames.front().length;
+    frames.pop_front();
+  }
+}
+
+bool RewindBuffer::place(std::size_t length) {
+  if (length > capacity) {
+    return false;
+  }
+
+  // Records are contiguous, so skip the end of the ring if it is too small.
+  // Whatever is stored there is older than what is at the start.
+  if (write_pos + length > capacity) {
+    while (!frames.empty() && frames.front().offset >= write_pos) {
+      dropOldest();
+    }
+    write_pos = 0;
+  }
+
+  while (!frames.empty()
+         && frames.front().offset < write_pos + length
+         && write_pos < frames.front().offset + frames.front().length) {
+    dropOldest();
+  }
+  while (frames.size() >= max_frames) {
+    dropOldest();
+  }
+  return true;
+}
+
+void RewindBuffer::capture(Emulator const& emulator) {
+  emulator.saveState(state.data(), state.size());
+
+  bool keyframe = !have_keyframe || since_keyframe + 1 >= keyframe_interval;
+  std::size_t length;
+  for (;;) {
+    length = encode(state.data(), keyframe ? nullptr : keyframe_state.data());
+    place(length);
+
+    // Making room may have thrown out the keyframe this delta is based on
+    if (!keyframe && (frames.empty() || frames.front().sequence > current_keyframe)) {
+      keyframe = true;
+      continue;
+    }
+    break;
+  }
+
+  memcpy(&ring.at(write_pos), encoded.data(), length);
+  uint64_t const sequence = next_sequence++;
+  Frame const frame = { write_pos, length, sequence,
+                        keyframe ? sequence : current_keyframe };
+  frames.push_back(frame);
+  write_pos += length;
+  used += length;
+
+  if (keyframe) {
+    current_keyframe = sequence;
+    have_keyframe = true;
+    since_keyframe = 0;
+    keyframe_state.swap(state);
+  } else {
+    ++since_keyframe;
+  }
+}
+
+bool RewindBuffer::restore(std::size_t frames_back, Emulator& emulator) {
+  if (frames_back >= frames.size()) {
+    error_msg = "Only " + std::to_string(frames.size()) + " frames available";
+    return false;
+  }
+
+  Frame const& frame = frames.at(frames.size() - 1 - frames_back);
+  std::fill(state.begin(), state.end(), 0);
+  if (frame.keyframe != frame.sequence) {
+    decode(frames.at(frame.keyframe - frames.front().sequence), state.data());
+  }
+  decode(frame, state.data());
+
+  if (!emulator.loadState(state.data(), state.size())) {
+    error_msg = emulator.getError();
+    return false;
+  }
+  return true;
+}
+
+void RewindBuffer::discardNewest(std::size_t frames_back) {
+  for (std::size_t i = 0; i < frames_back && !frames.empty(); ++i) {
+    used -= frames.back().length;
+    frames.pop_back();
+  }
+
+  if (frames.empty()) {
+    write_pos = 0;
+    have_keyframe = false;
+    return;
+  }
+
+  Frame const& newest = frames.back();
+  write_pos = newest.offset + newest.length;
+  next_sequence = newest.sequence + 1;
+  since_keyframe = newest.sequence - newest.keyframe;
+  if (current_keyframe != newest.keyframe) {
+    current_keyframe = newest.keyframe;
+    std::fill(keyframe_state.begin(), keyframe_state.end(), 0);
+    decode(frames.at(current_keyframe - frames.front().sequence),
+           keyframe_state.data());
+  }
+}
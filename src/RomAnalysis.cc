@@ -0,0 +1,190 @@
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+
+#include "chip8core/RomAnalysis.h"
+
+namespace {
+
+std::mutex cache_mutex;
+std::unordered_map<uint64_t, std::weak_ptr<RomAnalysis const>> cache;
+
+} // anonymous namespace
+
+uint16_t constexpr RomAnalysis::start_address;
+
+RomAnalysis::RomAnalysis(uint8_t const* data, std::size_t size) :
+  rom(data, data + size),
+  content_hash(contentHash(data, size)),
+  opcodes(size),
+  flags(size),
+  block_starts()
+  {
+    analyse();
+}
+
+std::shared_ptr<RomAnalysis const> RomAnalysis::get(uint8_t const* data,
+                                                    std::size_t size) {
+  uint64_t const key = contentHash(data, size);
+  std::lock_guard<std::mutex> lock(cache_mutex);
+
+  std::weak_ptr<RomAnalysis const>& entry = cache[key];
+  std::shared_ptr<RomAnalysis const> analysis = entry.lock();
+  if (analysis && analysis->size() == size
+      && memcmp(analysis->data(), data, size) == 0) {
+    return analysis;
+  }
+
+  // Analysing under the lock means instances started together wait for the
+  // first one rather than all doing the same work
+  analysis = std::make_shared<RomAnalysis const>(data, size);
+  if (entry.expired()) {
+    entry = analysis;
+  }
+
+  for (auto it = cache.begin(); it != cache.end(); ) {
+    it = it->second.expired() ? cache.erase(it) : std::next(it);
+  }
+  return analysis;
+}
+
+std::size_t RomAnalysis::cacheSize() {
+  std::lock_guard<std::mutex> lock(cache_mutex);
+  std::size_t live = 0;
+  for (auto const& entry : cache) {
+    live += entry.second.expired() ? 0 : 1;
+  }
+  return live;
+}
+
+uint64_t RomAnalysis::contentHash(uint8_t const* data, std::size_t size) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (std::size_t i = 0; i < size; ++i) {
+    hash = (hash ^ data[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+uint64_t RomAnalysis::hash() const {
+  return content_hash;
+}
+
+std::size_t RomAnalysis::size() const {
+  return rom.size();
+}
+
+uint8_t const* RomAnalysis::data() const {
+  return rom.data();
+}
+
+bool RomAnalysis::contains(uint16_t address) const {
+  return address >= start_address
+      && static_cast<std::size_t>(address - start_address) + 1 < rom.size();
+}
+
+uint16_t RomAnalysis::opcode(uint16_t address) const {
+  return opcodes[address - start_address];
+}
+
+bool RomAnalysis::hasFlag(uint16_t address, Flag flag) const {
+  return address >= start_address
+      && static_cast<std::size_t>(address - start_address) < rom.size()
+      && (flags[address - start_address] & flag) != 0;
+}
+
+bool RomAnalysis::isInstruction(uint16_t address) const {
+  return hasFlag(address, Instruction);
+}
+
+bool RomAnalysis::isCode(uint16_t address) const {
+  return hasFlag(address, Code);
+}
+
+bool RomAnalysis::isJumpTarget(uint16_t address) const {
+  return hasFlag(address, JumpTarget);
+}
+
+bool RomAnalysis::isBlockStart(uint16_t address) const {
+  return hasFlag(address, BlockStart);
+}
+
+std::vector<uint16_t> const& RomAnalysis::blockStarts() const {
+  return block_starts;
+}
+
+void RomAnalysis::analyse() {
+  for (std::size_t i = 0; i < rom.size(); ++i) {
+    uint8_t const next = i + 1 < rom.size() ? rom[i + 1] : 0;
+    opcodes[i] = (rom[i] << 8) | next;
+  }
+
+  std::vector<uint16_t> pending;
+  auto follow = [&](uint16_t address, uint8_t extra_flags) {
+    if (contains(address)) {
+      flags[address - start_address] |= extra_flags;
+      pending.push_back(address);
+    }
+  };
+  follow(start_address, BlockStart);
+
+  while (!pending.empty()) {
+    uint16_t const address = pending.back();
+    pending.pop_back();
+    if (isInstruction(address)) {
+      continue;
+    }
+    flags[address - start_address] |= Instruction | Code;
+    flags[address - start_address + 1] |= Code;
+
+    uint16_t const op = opcode(address);
+    uint16_t const nnn = op & 0x0FFF;
+    uint16_t const next = address + 2;
+
+    switch (op >> 12) {
+      case 0x0:
+        if (op != 0x00EE && op != 0x00FD) {
+          follow(next, 0);
+        }
+        break;
+
+      case 0x1:
+        follow(nnn, JumpTarget | BlockStart);
+        break;
+
+      case 0x2:
+        follow(nnn, JumpTarget | BlockStart);
+        follow(next, BlockStart);
+        break;
+
+      // Skips end a block, and either instruction after may run
+      case 0x3: case 0x4: case 0x5: case 0x9:
+        follow(next, BlockStart);
+        follow(next + 2, BlockStart);
+        break;
+
+      case 0xE:
+        if ((op & 0xFF) == 0x9E || (op & 0xFF) == 0xA1) {
+          follow(next, BlockStart);
+          follow(next + 2, BlockStart);
+        } else {
+          follow(next, 0);
+        }
+        break;
+
+      // The target of 0xBNNN depends on V0, so it cannot be followed
+      case 0xB:
+        break;
+
+      default:
+        follow(next, 0);
+        break;
+    }
+  }
+
+  for (std::size_t i = 0; i < rom.size(); ++i) {
+    if (flags[i] & BlockStart) {
+      block_starts.push_back(start_address + i);
+    }
+  }
+}
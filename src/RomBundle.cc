@@ -0,0 +1,205 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include "chip8core/RomAnalysis.h"
+#include "chip8core/RomBundle.h"
+
+namespace {
+
+char const bundle_magic[4] = { 'C', '8', 'R', 'B' };
+
+void put(std::vector<uint8_t>& out, uint64_t value, unsigned bytes) {
+  for (unsigned i = 0; i < bytes; ++i) {
+    out.push_back((value >> (8 * i)) & 0xFF);
+  }
+}
+
+uint64_t get(uint8_t const* in, unsigned bytes) {
+  uint64_t value = 0;
+  for (unsigned i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(in[i]) << (8 * i);
+  }
+  return value;
+}
+
+} // anonymous namespace
+
+std::size_t constexpr RomBundle::npos;
+uint16_t constexpr RomBundle::version;
+std::size_t constexpr RomBundle::header_size;
+std::size_t constexpr RomBundle::index_entry_size;
+
+RomBundle::RomBundle() :
+  image(),
+  num_entries(0),
+  error_msg()
+  {}
+
+bool RomBundle::open(std::string const& filename) {
+  num_entries = 0;
+  if (!image.mapFile(filename)) {
+    error_msg = image.getError();
+    return false;
+  }
+
+  uint8_t const* const data = image.data();
+  std::size_t const size = image.size();
+  if (size < header_size || memcmp(data, bundle_magic, sizeof(bundle_magic)) != 0) {
+    error_msg = "Not a ROM bundle";
+    return false;
+  }
+  if (get(data + 4, 2) != version) {
+    error_msg = "Unsupported ROM bundle version " + std::to_string(get(data + 4, 2));
+    return false;
+  }
+
+  // Check every range once here, so lookups need no checks
+  std::size_t const count = get(data + 8, 4);
+  if (count > (size - header_size) / index_entry_size) {
+    error_msg = "Corrupt ROM bundle";
+    return false;
+  }
+  for (std::size_t i = 0; i < count; ++i) {
+    uint8_t const* const entry = data + header_size + i * index_entry_size;
+    uint64_t const name_end = get(entry, 4) + get(entry + 4, 4);
+    uint64_t const data_end = get(entry + 16, 4) + get(entry + 20, 4);
+    if (name_end > size || data_end > size) {
+      error_msg = "Corrupt ROM bundle";
+      return false;
+    }
+  }
+
+  num_entries = count;
+  return true;
+}
+
+std::size_t RomBundle::size() const {
+  return num_entries;
+}
+
+uint8_t const* RomBundle::indexEntry(std::size_t index) const {
+  return image.data() + header_size + index * index_entry_size;
+}
+
+std::string RomBundle::name(std::size_t index) const {
+  uint8_t const* const entry = indexEntry(index);
+  return std::string(reinterpret_cast<char const*>(image.data() + get(entry, 4)),
+                     get(entry + 4, 4));
+}
+
+RomBundle::Entry RomBundle::entry(std::size_t index) const {
+  if (index >= num_entries) {
+    throw std::out_of_range("RomBundle: entry out of range");
+  }
+
+  uint8_t const* const entry = indexEntry(index);
+  Entry const result = {
+    name(index),
+    get(entry + 8, 8),
+    static_cast<uint32_t>(get(entry + 24, 4)),
+    image.data() + get(entry + 16, 4),
+    static_cast<std::size_t>(get(entry + 20, 4))
+  };
+  return result;
+}
+
+std::size_t RomBundle::find(std::string const& wanted) const {
+  // The index is sorted by name
+  std::size_t low = 0;
+  std::size_t high = num_entries;
+  while (low < high) {
+    std::size_t const middle = low + (high - low) / 2;
+    uint8_t const* const entry = indexEntry(middle);
+    std::size_t const length = get(entry + 4, 4);
+    int order = memcmp(image.data() + get(entry, 4), wanted.data(),
+                       std::min(length, wanted.size()));
+    if (order == 0) {
+      order = length < wanted.size() ? -1 : length > wanted.size() ? 1 : 0;
+    }
+
+    if (order == 0) {
+      return middle;
+    } else if (order < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return npos;
+}
+
+std::string const& RomBundle::getError() const {
+  return error_msg;
+}
+
+RomBundleWriter::RomBundleWriter() :
+  roms(),
+  error_msg()
+  {}
+
+void RomBundleWriter::add(std::string const& name, uint8_t const* data,
+                          std::size_t size, uint32_t quirks) {
+  Rom rom = { name, quirks, std::vector<uint8_t>(data, data + size) };
+  for (Rom& existing : roms) {
+    if (existing.name == name) {
+      existing = rom;
+      return;
+    }
+  }
+  roms.push_back(rom);
+}
+
+bool RomBundleWriter::write(std::string const& filename) {
+  std::sort(roms.begin(), roms.end(), [](Rom const& lhs, Rom const& rhs) {
+    return lhs.name < rhs.name;
+  });
+
+  std::vector<uint8_t> names;
+  std::vector<uint8_t> contents;
+  std::size_t const names_start = RomBundle::header_size
+                                + roms.size() * RomBundle::index_entry_size;
+  for (Rom const& rom : roms) {
+    names.insert(names.end(), rom.name.begin(), rom.name.end());
+    contents.insert(contents.end(), rom.data.begin(), rom.data.end());
+  }
+  if (names_start + names.size() + contents.size() > UINT32_MAX) {
+    error_msg = "ROM bundle too big";
+    return false;
+  }
+
+  std::vector<uint8_t> header;
+  header.insert(header.end(), bundle_magic, bundle_magic + sizeof(bundle_magic));
+  put(header, RomBundle::version, 2);
+  put(header, 0, 2);
+  put(header, roms.size(), 4);
+  put(header, 0, 4);
+
+  std::size_t name_offset = names_start;
+  std::size_t data_offset = names_start + names.size();
+  for (Rom const& rom : roms) {
+    put(header, name_offset, 4);
+    put(header, rom.name.size(), 4);
+    put(header, RomAnalysis::contentHash(rom.data.data(), rom.data.size()), 8);
+    put(header, data_offset, 4);
+    put(header, rom.data.size(), 4);
+    put(header, rom.quirks, 4);
+    put(header, 0, 4);
+    name_offset += rom.name.size();
+    data_offset += rom.data.size();
+  }
+
+  std::ofstream file(filename, std::ios::binary);
+  file.write(reinterpret_cast<char const*>(header.data()), header.size());
+  file.write(reinterpret_cast<char const*>(names.data()), names.size());
+  file.write(reinterpret_cast<char const*>(contents.data()), contents.size());
+  if (!file) {
+    error_msg = "Error writing to " + filename;
+    return false;
+  }
+  return true;
+}
+
+std::string const& RomBundleWriter::getError() const {
+  return error_msg;
+}
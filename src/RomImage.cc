@@ -0,0 +1,72 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "chip8core/RomImage.h"
+
+RomImage::RomImage() :
+  contents(nullptr),
+  length(0),
+  mapped(nullptr),
+  buffer(),
+  error_msg()
+  {}
+
+RomImage::~RomImage() {
+  release();
+}
+
+void RomImage::release() {
+  if (mapped != nullptr) {
+    munmap(mapped, length);
+    mapped = nullptr;
+  }
+  buffer.clear();
+  contents = nullptr;
+  length = 0;
+}
+
+bool RomImage::mapFile(std::string const& filename) {
+  int const fd = open(filename.c_str(), O_RDONLY);
+  struct stat info;
+  if (fd < 0 || fstat(fd, &info) != 0 || info.st_size <= 0) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    error_msg = "File empty or not found";
+    return false;
+  }
+
+  void* const address = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (address == MAP_FAILED) {
+    error_msg = "Could not map " + filename;
+    return false;
+  }
+
+  release();
+  mapped = address;
+  contents = static_cast<uint8_t const*>(address);
+  length = info.st_size;
+  return true;
+}
+
+void RomImage::assign(uint8_t const* data, std::size_t size) {
+  release();
+  buffer.assign(data, data + size);
+  contents = buffer.data();
+  length = size;
+}
+
+uint8_t const* RomImage::data() const {
+  return contents;
+}
+
+std::size_t RomImage::size() const {
+  return length;
+}
+
+std::string const& RomImage::getError() const {
+  return error_msg;
+}
@@ -0,0 +1,257 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "chip8core/StateStore.h"
+
+namespace {
+
+char const store_magic[4] = { 'C', '8', 'S', 'B' };
+
+// Header offsets
+std::size_t constexpr count_offset = 16;
+
+// Record offsets
+std::size_t constexpr state_offset = 8;
+std::size_t constexpr crc_offset = state_offset + Emulator::state_size;
+
+void put(byte* out, uint64_t value, unsigned bytes) {
+  for (unsigned i = 0; i < bytes; ++i) {
+    out[i] = (value >> (8 * i)) & 0xFF;
+  }
+}
+
+uint64_t get(byte const* in, unsigned bytes) {
+  uint64_t value = 0;
+  for (unsigned i = 0; i < bytes; ++i) {
+    value |= static_cast<uint64_t>(in[i]) << (8 * i);
+  }
+  return value;
+}
+
+struct Crc32Table {
+  Crc32Table() {
+    for (uint32_t i = 0; i < 256; ++i) {
+      uint32_t value = i;
+      for (unsigned bit = 0; bit < 8; ++bit) {
+        value = (value & 1) ? 0xEDB88320U ^ (value >> 1) : value >> 1;
+      }
+      entries[i] = value;
+    }
+  }
+  uint32_t entries[256];
+};
+
+uint32_t crc32(byte const* data, std::size_t size) {
+  static Crc32Table const table;
+  uint32_t crc = 0xFFFFFFFFU;
+  for (std::size_t i = 0; i < size; ++i) {
+    crc = table.entries[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  }
+  return crc ^ 0xFFFFFFFFU;
+}
+
+bool writeAll(int fd, byte const* data, std::size_t size, off_t offset) {
+  while (size > 0) {
+    ssize_t const written = pwrite(fd, data, size, offset);
+    if (written <= 0) {
+      return false;
+    }
+    data += written;
+    size -= written;
+    offset += written;
+  }
+  return true;
+}
+
+} // anonymous namespace
+
+uint16_t constexpr StateStore::version;
+std::size_t constexpr StateStore::header_size;
+std::size_t constexpr StateStore::record_size;
+
+StateStore::StateStore() :
+  fd(-1),
+  writable(false),
+  mapped(nullptr),
+  mapped_length(0),
+  num_records(0),
+  error_msg()
+  {}
+
+StateStore::~StateStore() {
+  close();
+}
+
+std::string const& StateStore::getError() const {
+  return error_msg;
+}
+
+std::size_t StateStore::size() const {
+  return num_records;
+}
+
+bool StateStore::map(std::size_t length) {
+  unmap();
+  void* const address = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+  if (address == MAP_FAILED) {
+    error_msg = std::string("Could not map state store: ") + strerror(errno);
+    return false;
+  }
+  mapped = static_cast<byte*>(address);
+  mapped_length = length;
+  return true;
+}
+
+void StateStore::unmap() {
+  if (mapped != nullptr) {
+    munmap(mapped, mapped_length);
+    mapped = nullptr;
+    mapped_length = 0;
+  }
+}
+
+void StateStore::close() {
+  unmap();
+  if (fd >= 0) {
+    ::close(fd);
+    fd = -1;
+  }
+  num_records = 0;
+}
+
+bool StateStore::open(std::string const& filename, bool write) {
+  close();
+  writable = write;
+  fd = ::open(filename.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+  if (fd < 0) {
+    error_msg = "File not found";
+    return false;
+  }
+
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    error_msg = std::string("Could not stat state store: ") + strerror(errno);
+    close();
+    return false;
+  }
+
+  if (info.st_size == 0 && writable) {
+    byte header[header_size] = { 0 };
+    memcpy(header, store_magic, sizeof(store_magic));
+    put(header + 4, version, 2);
+    put(header + 8, Emulator::state_size, 4);
+    put(header + 12, record_size, 4);
+    if (!writeAll(fd, header, sizeof(header), 0)) {
+      error_msg = "Error writing to " + filename;
+      close();
+      return false;
+    }
+    info.st_size = header_size;
+  }
+
+  if (static_cast<std::size_t>(info.st_size) < header_size) {
+    error_msg = "Not a state store";
+    close();
+    return false;
+  }
+  if (!map(info.st_size)) {
+    close();
+    return false;
+  }
+
+  if (memcmp(mapped, store_magic, sizeof(store_magic)) != 0) {
+    error_msg = "Not a state store";
+    close();
+    return false;
+  }
+  if (get(mapped + 4, 2) != version) {
+    error_msg = "Unsupported state store version "
+              + std::to_string(get(mapped + 4, 2));
+    close();
+    return false;
+  }
+
+  uint64_t const count = get(mapped + count_offset, 8);
+  if (get(mapped + 8, 4) != Emulator::state_size
+      || get(mapped + 12, 4) != record_size
+      || count > (info.st_size - header_size) / record_size) {
+    error_msg = "Corrupt state store";
+    close();
+    return false;
+  }
+  num_records = count;
+  return true;
+}
+
+byte const* StateStore::record(std::size_t index) const {
+  return mapped + header_size + index * record_size;
+}
+
+bool StateStore::append(Emulator const& emulator, uint64_t key) {
+  if (fd < 0 || !writable) {
+    error_msg = "State store not open for writing";
+    return false;
+  }
+
+  std::vector<byte> buffer(record_size);
+  put(buffer.data(), key, 8);
+  emulator.saveState(buffer.data() + state_offset, Emulator::state_size);
+  put(buffer.data() + crc_offset, crc32(buffer.data(), crc_offset), 4);
+
+  // The record goes in before the count, so a crash between the two only
+  // leaves unreferenced bytes at the end of the file
+  std::size_t const end = header_size + (num_records + 1) * record_size;
+  byte count[8];
+  put(count, num_records + 1, 8);
+  if (!writeAll(fd, buffer.data(), record_size, end - record_size)
+      || !writeAll(fd, count, sizeof(count), count_offset)) {
+    error_msg = "Error writing to state store";
+    return false;
+  }
+
+  // Grow the mapping geometrically, so appends do not remap every time
+  if (end > mapped_length && !map(std::max(end, mapped_length * 2))) {
+    close();
+    return false;
+  }
+  ++num_records;
+  return true;
+}
+
+bool StateStore::verify(std::size_t index) const {
+  if (index >= num_records) {
+    return false;
+  }
+  byte const* const data = record(index);
+  return crc32(data, crc_offset) == get(data + crc_offset, 4);
+}
+
+uint64_t StateStore::key(std::size_t index) const {
+  if (index >= num_records) {
+    throw std::out_of_range("StateStore: record out of range");
+  }
+  return get(record(index), 8);
+}
+
+bool StateStore::restore(std::size_t index, Emulator& emulator) {
+  if (index >= num_records) {
+    error_msg = "Only " + std::to_string(num_records) + " records available";
+    return false;
+  }
+  if (!verify(index)) {
+    error_msg = "Checksum mismatch in record " + std::to_string(index);
+    return false;
+  }
+  if (!emulator.loadState(record(index) + state_offset, Emulator::state_size)) {
+    error_msg = emulator.getError();
+    return false;
+  }
+  return true;
+}
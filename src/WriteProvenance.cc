@@ -0,0 +1,80 @@
+#include <algorithm>
+
+#include "chip8core/Emulator.h"
+#include "chip8core/WriteProvenance.h"
+
+namespace {
+
+// Instruction numbers share a record with the program counter
+uint64_t constexpr max_instructions = uint64_t(1) << 48;
+
+} // anonymous namespace
+
+WriteProvenance::WriteProvenance() :
+  ram(Emulator::ram_size),
+  screen(Emulator::screen_bytes),
+  records(0)
+  {}
+
+void WriteProvenance::recordRam(std::size_t address, std::size_t length,
+                                uint16_t program_counter,
+                                uint64_t instruction) {
+  std::size_t const end = std::min(address + length, ram.size());
+  for (std::size_t i = address; i < end; ++i) {
+    record(ram[i], program_counter, instruction);
+  }
+  records += end > address ? end - address : 0;
+}
+
+void WriteProvenance::recordScreen(std::size_t offset,
+                                   uint16_t program_counter,
+                                   uint64_t instruction) {
+  if (offset < screen.size()) {
+    record(screen[offset], program_counter, instruction);
+    ++records;
+  }
+}
+
+bool WriteProvenance::lastRamWrite(std::size_t address, uint64_t before,
+                                   Write& write) const {
+  return address < ram.size() && find(ram[address], before, write);
+}
+
+bool WriteProvenance::lastScreenChange(std::size_t offset, uint64_t before,
+                                       Write& write) const {
+  return offset < screen.size() && find(screen[offset], before, write);
+}
+
+std::size_t WriteProvenance::size() const {
+  return records;
+}
+
+void WriteProvenance::clear() {
+  for (Chain& chain : ram) {
+    Chain().swap(chain);
+  }
+  for (Chain& chain : screen) {
+    Chain().swap(chain);
+  }
+  records = 0;
+}
+
+void WriteProvenance::record(Chain& chain, uint16_t program_counter,
+                             uint64_t instruction) {
+  chain.push_back(instruction << 16 | program_counter);
+}
+
+bool WriteProvenance::find(Chain const& chain, uint64_t before,
+                           Write& write) {
+  // First record of instruction before or later, then step back
+  auto const later = before >= max_instructions
+    ? chain.end()
+    : std::lower_bound(chain.begin(), chain.end(), before << 16);
+  if (later == chain.begin()) {
+    return false;
+  }
+  uint64_t const packed = *(later - 1);
+  write.program_counter = packed & 0xFFFF;
+  write.instruction = packed >> 16;
+  return true;
+}
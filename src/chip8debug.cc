@@ -0,0 +1,199 @@
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "chip8core/DebugServer.h"
+
+using namespace std;
+
+namespace {
+
+int help(char const* name) {
+  cerr << "Usage: " << name << " SOCKET COMMAND [ARGUMENTS]\n"
+       << "\n"
+       << "Commands, with hexadecimal numbers:\n"
+       << "  pause                  Stop ticking the emulator\n"
+       << "  continue               Tick again, also after a breakpoint\n"
+       << "  step [COUNT]           Pause and execute COUNT instructions\n"
+       << "  status                 Print registers and why execution stopped\n"
+       << "  set REGISTER VALUE     Set V0-VF, I or PC\n"
+       << "  read ADDRESS LENGTH    Dump RAM\n"
+       << "  write ADDRESS BYTE...  Write bytes to RAM\n"
+       << "  screen                 Print the screen\n"
+       << "  break ADDRESS          Set a breakpoint\n"
+       << "  unbreak ADDRESS        Remove a breakpoint\n"
+       << "  watch ADDRESS LENGTH r|w|rw    Set a watchpoint\n"
+       << "  unwatch ADDRESS LENGTH r|w|rw  Remove a watchpoint\n"
+       << "  clear                  Remove all breakpoints and watchpoints\n";
+  return 1;
+}
+
+uint16_t number(string const& text) {
+  unsigned long const value = stoul(text, nullptr, 16);
+  if (value > 0xFFFF) {
+    throw out_of_range(text);
+  }
+  return static_cast<uint16_t>(value);
+}
+
+uint16_t registerNumber(string const& text) {
+  if (text == "I" || text == "i") {
+    return 16;
+  }
+  if (text == "PC" || text == "pc") {
+    return 17;
+  }
+  if (text.size() == 2 && (text[0] == 'V' || text[0] == 'v')) {
+    return number(text.substr(1));
+  }
+  throw invalid_argument(text);
+}
+
+char const* stopReasonName(StopReason reason) {
+  switch (reason) {
+    case StopReason::None:            return "none";
+    case StopReason::Breakpoint:      return "breakpoint";
+    case StopReason::ReadWatchpoint:  return "read watchpoint";
+    case StopReason::WriteWatchpoint: return "write watchpoint";
+  }
+  return "unknown";
+}
+
+void printStatus(DebugStatus const& status) {
+  cout << hex << setfill('0')
+       << "PC " << setw(4) << status.program_counter
+       << "  I " << setw(4) << status.index_register
+       << "  stack " << dec << static_cast<unsigned>(status.stack_depth)
+       << "  instructions " << status.instruction_count
+       << (status.paused ? "  paused" : "") << "\n";
+  for (unsigned i = 0; i < Emulator::num_registers; ++i) {
+    cout << "V" << hex << uppercase << i << nouppercase << " "
+         << setw(2) << static_cast<unsigned>(status.registers[i])
+         << (i % 8 == 7 ? "\n" : "  ");
+  }
+  if (status.stop_reason != StopReason::None) {
+    cout << "Stopped at " << stopReasonName(status.stop_reason) << " "
+         << setw(4) << status.stop_address << "\n";
+  }
+}
+
+void printDump(uint16_t address, vector<byte> const& data) {
+  cout << hex << setfill('0');
+  for (size_t i = 0; i < data.size(); ++i) {
+    if (i % 16 == 0) {
+      cout << (i > 0 ? "\n" : "") << setw(4) << address + i << ":";
+    }
+    cout << " " << setw(2) << static_cast<unsigned>(data[i]);
+  }
+  cout << "\n";
+}
+
+void printScreen(vector<byte> const& screen) {
+  for (unsigned row = 0; row < Emulator::screen_rows; ++row) {
+    for (unsigned column = 0; column < Emulator::screen_columns; ++column) {
+      byte const bits = screen.at(row * Emulator::screen_columns + column);
+      for (int bit = 7; bit >= 0; --bit) {
+        cout << ((bits >> bit) & 1 ? '#' : '.');
+      }
+    }
+    cout << "\n";
+  }
+}
+
+vector<byte> watchPayload(string const& type, bool on) {
+  unsigned mask = 0;
+  if (type.find('r') != string::npos) {
+    mask |= WatchRead;
+  }
+  if (type.find('w') != string::npos) {
+    mask |= WatchWrite;
+  }
+  if (mask == 0) {
+    throw invalid_argument(type);
+  }
+  return vector<byte> { static_cast<byte>(mask), static_cast<byte>(on) };
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    return help(argv[0]);
+  }
+  string const command = argv[2];
+  vector<string> const args(argv + 3, argv + argc);
+
+  DebugClient client;
+  if (!client.connect(argv[1])) {
+    cerr << argv[0] << ": " << client.getError() << "\n";
+    return 1;
+  }
+
+  vector<byte> response;
+  bool ok = false;
+  try {
+    if (command == "pause" && args.empty()) {
+      ok = client.request(DebugCommand::Pause, 0, 0);
+    } else if (command == "continue" && args.empty()) {
+      ok = client.request(DebugCommand::Continue, 0, 0);
+    } else if (command == "step" && args.size() <= 1) {
+      uint16_t const count = args.empty() ? 1 : number(args[0]);
+      ok = client.request(DebugCommand::Step, count, 0)
+        && client.request(DebugCommand::Status, 0, 0, {}, response);
+      if (ok) {
+        printStatus(DebugStatus::read(response.data()));
+      }
+    } else if (command == "status" && args.empty()) {
+      ok = client.request(DebugCommand::Status, 0, 0, {}, response);
+      if (ok) {
+        printStatus(DebugStatus::read(response.data()));
+      }
+    } else if (command == "set" && args.size() == 2) {
+      ok = client.request(DebugCommand::SetRegister, registerNumber(args[0]),
+                          number(args[1]));
+    } else if (command == "read" && args.size() == 2) {
+      uint16_t const address = number(args[0]);
+      ok = client.request(DebugCommand::ReadRam, address, number(args[1]),
+                          {}, response);
+      if (ok) {
+        printDump(address, response);
+      }
+    } else if (command == "write" && args.size() >= 2) {
+      vector<byte> bytes;
+      for (size_t i = 1; i < args.size(); ++i) {
+        bytes.push_back(static_cast<byte>(number(args[i])));
+      }
+      ok = client.request(DebugCommand::WriteRam, number(args[0]), 0,
+                          bytes, response);
+    } else if (command == "screen" && args.empty()) {
+      ok = client.request(DebugCommand::ReadScreen, 0, Emulator::screen_bytes,
+                          {}, response);
+      if (ok) {
+        printScreen(response);
+      }
+    } else if ((command == "break" || command == "unbreak")
+               && args.size() == 1) {
+      ok = client.request(DebugCommand::SetBreakpoint, number(args[0]),
+                          command == "break");
+    } else if ((command == "watch" || command == "unwatch")
+               && args.size() == 3) {
+      ok = client.request(DebugCommand::SetWatchpoint, number(args[0]),
+                          number(args[1]),
+                          watchPayload(args[2], command == "watch"), response);
+    } else if (command == "clear" && args.empty()) {
+      ok = client.request(DebugCommand::ClearDebugPoints, 0, 0);
+    } else {
+      return help(argv[0]);
+    }
+  } catch (logic_error& e) {
+    cerr << argv[0] << ": Invalid argument " << e.what() << "\n";
+    return 1;
+  }
+
+  if (!ok) {
+    cerr << argv[0] << ": " << client.getError() << "\n";
+    return 1;
+  }
+  return 0;
+}
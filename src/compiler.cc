@@ -1,178 +1,19 @@
+#include <cerrno>
+#include <cstring>
 #include <iostream>
-#include <fstream>
-#include <sstream>
-#include <map>
-#include <functional>
+#include <string>
+#include <vector>
 
-using namespace std;
-
-namespace {
-
-namespace io {
-
-enum token_type {
-  REG,
-  NN
-};
-
-ofstream outfile;
-ifstream infile;
-
-void exit_ok() {
-  infile.close();
-  outfile.close();
-  exit(0);
-}
-
-void exit_err(string const& error) {
-  cerr << error;
-  infile.close();
-  outfile.close();
-  exit(1);
-}
-
-void write_bins(char lhs, char rhs) {
-  outfile.write(static_cast<char*>(&lhs), 1);
-  outfile.write(static_cast<char*>(&rhs), 1);
-  if (outfile.fail()) {
-    exit_err("Error writing to disk");
-  }
-}
-
-int xtoi(string const& x) {
-  try {
-    return stoi(x, 0, 16);
-  } catch (exception &e) {
-    return -1;
-  }
-}
-
-string next_token() {
-  string value;
-  io::infile >> value;
-  if (!io::infile) {
-    io::exit_ok();
-  }
-  return value;
-}
-
-void tok2n(string const& name, string&& value, char& n) {
-  int target = xtoi(value);
-  if (0 > target || 0xF < target) {
-    exit_err("Error: " + name + " needs to be supplied with a value [0-F]\n");
-  }
-  n = target;
-}
-
-void tok2nn(string const& name, string&& value, char& nn) {
-  int target = xtoi(value);
-  if (0 > target || 0xFF < target) {
-    exit_err("Error: " + name + " needs to be supplied with a value [0-FF]\n");
-  }
-  nn = target;
-}
-
-void tok2nnn(string const& name, string&& value, char& lhs, char& rhs) {
-  int target = xtoi(value);
-  if (0 > target || 0xFFF < target) {
-    exit_err("Error: " + name + " needs to be supplied with a value [0-FFF]\n");
-  }
-  lhs = target >> 8;
-  rhs = target & 0xFF;
-}
-
-void tok2nnnn(string const& name, string&& value, char& lhs, char& rhs) {
-  int target = xtoi(value);
-  if (0 > target || 0xFFFF < target) {
-    exit_err("Error: " + name + " needs to be supplied with a value [0-FFFF]\n");
-  }
-  lhs = target >> 8;
-  rhs = target & 0xFF;
-}
-
-void tok2reg(string const& name, string&& value, char& reg) {
-  if (value.at(0) != 'r') {
-    exit_err("Error: " + name + " needs to be supplied with a register r[0-F]\n");
-  }
-
-  int target = xtoi(value.substr(1));
-  if (0 > target || 0xF < target) {
-    exit_err("Error: " + name + " needs to be supplied with a register r[0-F]\n");
-  }
-  reg = target;
-}
-
-void tok2reg_or_nn(string const& name, string&& value, char& reg_or_nn, io::token_type& t) {
-  if (value.at(0) == 'r') {
-    t = REG;
-    tok2reg(name, forward<string>(value), reg_or_nn);
-  } else {
-    t = NN;
-    tok2nn(name, forward<string>(value), reg_or_nn);
-  }
-}
-
-} // io
-
-namespace op {
-
-// These variables are shared between all below functions
-char lhs;
-char rhs;
-char rhs2;
-io::token_type t;
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-inline void OP(char lhs, char rhs) { io::write_bins(lhs, rhs); }
+#include "chip8core/Assembler.h"
 
-inline void R(string const& name, char lop, char rop) {
-  io::tok2reg(name, io::next_token(), lhs);
-  io::write_bins(lop + lhs, rop);
-}
-
-inline void RR(string const& name, char lop, char rop) {
-  io::tok2reg(name, io::next_token(), lhs);
-  io::tok2reg(name, io::next_token(), rhs);
-  io::write_bins(lop + lhs, (rhs << 4) + rop);
-}
-
-inline void N(string const& name, char lop, char rop) {
-  io::tok2n(name, io::next_token(), lhs);
-  io::write_bins(lop + lhs, rop);
-}
-
-inline void NNN(string const& name, char op) {
-  io::tok2nnn(name, io::next_token(), lhs, rhs);
-  io::write_bins(op + lhs, rhs);
-}
-
-inline void RNN(string const& name, char lop) {
-  io::tok2reg(name, io::next_token(), lhs);
-  io::tok2nn(name, io::next_token(), rhs);
-  io::write_bins(lop + lhs, rhs);
-}
-
-inline void RRN(string const& name, char lop) {
-  io::tok2reg(name, io::next_token(), lhs);
-  io::tok2reg(name, io::next_token(), rhs);
-  io::tok2n(name, io::next_token(), rhs2);
-  io::write_bins(lop + lhs, (rhs << 4) + rhs2);
-}
-
-inline void RV(string const& name, char nnop, char rlop, char rrop) {
-  io::tok2reg(name, io::next_token(), lhs);
-  io::tok2reg_or_nn(name, io::next_token(), rhs, t);
-  if (t == io::NN)       { io::write_bins(nnop + lhs, rhs); }
-  else if (t == io::REG) { io::write_bins(rlop + lhs, (rhs << 4) + rrop); }
-  else                   { io::exit_err(name + ": Unknown type\n"); }
-}
-
-inline void DATA(string const& name) {
-  io::tok2nnnn(name, io::next_token(), lhs, rhs);
-  io::write_bins(lhs, rhs);
-}
-
-} // op
+using namespace std;
 
+namespace {
 
 int help(string program_name) {
   cerr
@@ -218,6 +59,39 @@ int help(string program_name) {
   return 1;
 }
 
+bool readFile(int fd, vector<char>& data) {
+  char chunk[65536];
+  for (;;) {
+    ssize_t const got = read(fd, chunk, sizeof(chunk));
+    if (got < 0 && errno == EINTR) {
+      continue;
+    }
+    if (got < 0) {
+      return false;
+    }
+    if (got == 0) {
+      return true;
+    }
+    data.insert(data.end(), chunk, chunk + got);
+  }
+}
+
+bool writeFile(int fd, vector<uint8_t> const& data) {
+  uint8_t const* pos = data.data();
+  size_t left = data.size();
+  while (left > 0) {
+    ssize_t const written = write(fd, pos, left);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      return false;
+    }
+    pos += written;
+    left -= written;
+  }
+  return true;
+}
 
 } // anonymous namespace
 
@@ -226,71 +100,62 @@ int main(int argc, char* argv[]) {
     return help(argv[0]);
   }
 
-  io::infile = ifstream(argv[1], ios::binary);
-  if (!io::infile) {
+  int const infile = open(argv[1], O_RDONLY);
+  struct stat info;
+  if (infile < 0 || fstat(infile, &info) != 0) {
     cerr << argv[0] << ": Unable to open " << argv[1] << "\n";
     return 1;
   }
 
-  stringstream ss;
-  ss << argv[1] << ".out";
-  string const outfile_name{ss.str()};
-  io::outfile = ofstream(outfile_name, ios::binary);
-  if (!io::outfile) {
+  string const outfile_name = string(argv[1]) + ".out";
+  int const outfile = open(outfile_name.c_str(),
+                           O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (outfile < 0) {
     cerr << argv[0] << ": Unable to open " << outfile_name << "\n";
     return 1;
   }
 
-  map<string const, function<void()>> const op2fun {
-    {"CLS",  bind(op::OP,    0x00, 0xE0) },
-    {"RET",  bind(op::OP,    0x00, 0xEE) },
-    {"JMP",  bind(op::NNN,  "JMP", 0x10)},
-    {"CALL", bind(op::NNN, "CALL", 0x20)},
-    {"IFN",  bind(op::RV,   "IFN", 0x30, 0x50, 0x00)},
-    {"IF",   bind(op::RV,    "IF", 0x40, 0x90, 0x00)},
-    {"SET",  bind(op::RV,   "SET", 0x60, 0x80, 0x00)},
-    {"ADD",  bind(op::RV,   "ADD", 0x70, 0x80, 0x04)},
-    {"OR",   bind(op::RR,    "OR", 0x80, 0x01)},
-    {"AND",  bind(op::RR,   "AND", 0x80, 0x02)},
-    {"XOR",  bind(op::RR,   "XOR", 0x80, 0x03)},
-    {"SUB",  bind(op::RR,   "SUB", 0x80, 0x05)},
-    {"SHR",  bind(op::RR,   "SHR", 0x80, 0x06)},
-    {"RSUB", bind(op::RR,  "RSUB", 0x80, 0x07)},
-    {"SHL",  bind(op::RR,   "SHL", 0x80, 0x0E)},
-    {"IDX",  bind(op::NNN,  "IDX", 0xA0)},
-    {"JMP0", bind(op::NNN, "JMP0", 0xB0)},
-    {"RND",  bind(op::RNN,  "RND", 0xC0)},
-    {"DRAW", bind(op::RRN, "DRAW", 0xD0)},
-    {"IFK",  bind(op::R,    "IFK", 0xE0, 0x9E)},
-    {"IFNK", bind(op::R,   "IFNK", 0xE0, 0xA1)},
-    {"GDEL", bind(op::R,   "GDEL", 0xF0, 0x07)},
-    {"WKEY", bind(op::R,   "WKEY", 0xF0, 0x0A)},
-    {"SDEL", bind(op::R,   "SDEL", 0xF0, 0x15)},
-    {"SAUD", bind(op::R,   "SAUD", 0xF0, 0x18)},
-    {"IADD", bind(op::R,   "IADD", 0xF0, 0x1E)},
-    {"CHAR", bind(op::R,   "CHAR", 0xF0, 0x29)},
-    {"SEP",  bind(op::R,    "SEP", 0xF0, 0x33)},
-    {"STOR", bind(op::N,   "STOR", 0xF0, 0x55)},
-    {"LOAD", bind(op::N,   "LOAD", 0xF0, 0x65)},
-    {"DATA", bind(op::DATA,"DATA")},
-  };
-
-
-  for (;;) {
-    // This constructor will exit when no more input is received
-    string tok{io::next_token()};
-    if (tok.at(0) == ';') {
-      getline(io::infile, tok);
-      continue;
+  // The source is only ever read, so map it rather than copying it. Pipes
+  // and other files without a size, like /dev/stdin, are read instead.
+  bool const regular = S_ISREG(info.st_mode);
+  size_t size = regular ? info.st_size : 0;
+  void* source = nullptr;
+  vector<char> buffer;
+  if (regular && size > 0) {
+    source = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, infile, 0);
+    if (source == MAP_FAILED) {
+      cerr << argv[0] << ": Unable to read " << argv[1] << "\n";
+      return 1;
     }
-
-    auto const fun{op2fun.find(tok)};
-    if (fun == op2fun.end()) {
-      io::exit_err("Unknown command '" + tok + "'\n");
+  } else if (!regular) {
+    if (!readFile(infile, buffer)) {
+      cerr << argv[0] << ": Unable to read " << argv[1] << "\n";
+      return 1;
     }
+    source = buffer.data();
+    size = buffer.size();
+  }
+  close(infile);
 
-    fun->second();
+  Assembler assembler;
+  bool const ok = assembler.assemble(static_cast<char const*>(source), size);
+  if (regular && size > 0) {
+    munmap(source, size);
+  }
+  for (Assembler::Diagnostic const& diagnostic : assembler.getDiagnostics()) {
+    cerr << argv[1] << ":" << diagnostic.line << ":" << diagnostic.column
+         << (diagnostic.severity == Assembler::Diagnostic::Error
+             ? ": error: " : ": warning: ")
+         << diagnostic.message << "\n";
+  }
+  if (!ok) {
+    close(outfile);
+    return 1;
   }
 
-  // Not reached
+  if (!writeFile(outfile, assembler.getOutput()) || close(outfile) != 0) {
+    cerr << "Error writing to disk";
+    return 1;
+  }
+  return 0;
 }
@@ -0,0 +1,81 @@
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "chip8core/RomBundle.h"
+#include "chip8core/RomImage.h"
+
+using namespace std;
+
+namespace {
+
+int help(char const* name) {
+  cerr << "Usage: " << name << " pack BUNDLE FILE[:QUIRKS]...\n"
+       << "       " << name << " list BUNDLE\n"
+       << "\n"
+       << "pack: Write every FILE into BUNDLE, named after its file name.\n"
+       << "      QUIRKS is an optional hexadecimal quirk profile.\n"
+       << "list: Print the name, size, hash and quirks of every ROM in BUNDLE.\n";
+  return 1;
+}
+
+int pack(char const* name, string const& bundle_name, int argc, char* argv[]) {
+  RomBundleWriter writer;
+  for (int i = 0; i < argc; ++i) {
+    string path = argv[i];
+    uint32_t quirks = 0;
+    size_t const colon = path.rfind(':');
+    if (colon != string::npos) {
+      try {
+        quirks = stoul(path.substr(colon + 1), nullptr, 16);
+      } catch (exception& e) {
+        cerr << name << ": Invalid quirks in " << path << "\n";
+        return 1;
+      }
+      path.erase(colon);
+    }
+
+    RomImage rom;
+    if (!rom.mapFile(path)) {
+      cerr << name << ": " << path << ": " << rom.getError() << "\n";
+      return 1;
+    }
+    size_t const slash = path.rfind('/');
+    writer.add(slash == string::npos ? path : path.substr(slash + 1),
+               rom.data(), rom.size(), quirks);
+  }
+
+  if (!writer.write(bundle_name)) {
+    cerr << name << ": " << writer.getError() << "\n";
+    return 1;
+  }
+  return 0;
+}
+
+int list(char const* name, string const& bundle_name) {
+  RomBundle bundle;
+  if (!bundle.open(bundle_name)) {
+    cerr << name << ": " << bundle_name << ": " << bundle.getError() << "\n";
+    return 1;
+  }
+
+  for (size_t i = 0; i < bundle.size(); ++i) {
+    RomBundle::Entry const entry = bundle.entry(i);
+    cout << left << setw(16) << entry.name << right << dec << setw(6) << entry.size
+         << "  " << hex << setfill('0') << setw(16) << entry.hash
+         << "  " << setw(8) << entry.quirks << setfill(' ') << "\n";
+  }
+  return 0;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  if (argc >= 3 && !strcmp(argv[1], "pack")) {
+    return pack(argv[0], argv[2], argc - 3, argv + 3);
+  } else if (argc == 3 && !strcmp(argv[1], "list")) {
+    return list(argv[0], argv[2]);
+  }
+  return help(argv[0]);
+}
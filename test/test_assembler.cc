@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include "chip8core/Assembler.h"
+#include "chip8core/Emulator.h"
+
+TEST(Assembler, AllForms) {
+  Assembler assembler;
+  ASSERT_EQ(true, assembler.assemble(
+    "CLS RET JMP 123 CALL 0x456\n"
+    "IFN r1 2A IFN r1 r2 IF rA FF IF rA rB\n"
+    "SET r3 7 SET r3 r4 ADD r5 1 ADD r5 r6\n"
+    "OR r1 r2 AND r1 r2 XOR r1 r2 SUB r1 r2 SHR r1 r2 RSUB r1 r2 SHL r1 r2\n"
+    "IDX 300 JMP0 204 RND r7 0F DRAW r1 r2 5\n"
+    "IFK r8 IFNK r8 GDEL r9 WKEY r9 SDEL rC SAUD rC IADD rD CHAR rD SEP rE\n"
+    "STOR 3 LOAD F DATA BEEF\n"));
+
+  std::vector<uint8_t> const expected = {
+    0x00, 0xE0, 0x00, 0xEE, 0x11, 0x23, 0x24, 0x56,
+    0x31, 0x2A, 0x51, 0x20, 0x4A, 0xFF, 0x9A, 0xB0,
+    0x63, 0x07, 0x83, 0x40, 0x75, 0x01, 0x85, 0x64,
+    0x81, 0x21, 0x81, 0x22, 0x81, 0x23, 0x81, 0x25,
+    0x81, 0x26, 0x81, 0x27, 0x81, 0x2E,
+    0xA3, 0x00, 0xB2, 0x04, 0xC7, 0x0F, 0xD1, 0x25,
+    0xE8, 0x9E, 0xE8, 0xA1, 0xF9, 0x07, 0xF9, 0x0A,
+    0xFC, 0x15, 0xFC, 0x18, 0xFD, 0x1E, 0xFD, 0x29, 0xFE, 0x33,
+    0xF3, 0x55, 0xFF, 0x65, 0xBE, 0xEF,
+  };
+  ASSERT_EQ(expected, assembler.getOutput());
+  ASSERT_EQ(true, assembler.getDiagnostics().empty());
+}
+
+TEST(Assembler, Comments) {
+  Assembler assembler;
+  ASSERT_EQ(true, assembler.assemble("; SET r0 1\nCLS ;RET\n  ;\nRET"));
+  ASSERT_EQ(std::vector<uint8_t>({ 0x00, 0xE0, 0x00, 0xEE }),
+            assembler.getOutput());
+}
+
+TEST(Assembler, ReportsEveryError) {
+  Assembler assembler;
+  ASSERT_EQ(false, assembler.assemble("CLS\n  JMP 1000 CLS\nFOO\nSET rG 1"));
+  ASSERT_EQ(true, assembler.getOutput().empty());
+  ASSERT_EQ("Line 2, column 7: JMP needs to be supplied with a value [0-FFF]",
+            assembler.getError());
+
+  auto const& diagnostics = assembler.getDiagnostics();
+  ASSERT_EQ(3U, diagnostics.size());
+  ASSERT_EQ(Assembler::Diagnostic::Error, diagnostics[0].severity);
+  ASSERT_EQ(2U, diagnostics[0].line);
+  ASSERT_EQ(7U, diagnostics[0].column);
+  ASSERT_EQ(3U, diagnostics[1].line);
+  ASSERT_EQ(1U, diagnostics[1].column);
+  ASSERT_EQ("Unknown command 'FOO'", diagnostics[1].message);
+  ASSERT_EQ(4U, diagnostics[2].line);
+  ASSERT_EQ(5U, diagnostics[2].column);
+  ASSERT_EQ("SET needs to be supplied with a register r[0-F]",
+            diagnostics[2].message);
+
+  // A later assemble() starts over
+  ASSERT_EQ(true, assembler.assemble("CLS"));
+  ASSERT_EQ(true, assembler.getDiagnostics().empty());
+  ASSERT_EQ(true, assembler.getError().empty());
+}
+
+TEST(Assembler, IncompleteInstructionWarns) {
+  Assembler assembler;
+  ASSERT_EQ(true, assembler.assemble("CLS\nDRAW r1 r2"));
+  ASSERT_EQ(std::vector<uint8_t>({ 0x00, 0xE0 }), assembler.getOutput());
+  ASSERT_EQ(1U, assembler.getDiagnostics().size());
+  Assembler::Diagnostic const& warning = assembler.getDiagnostics()[0];
+  ASSERT_EQ(Assembler::Diagnostic::Warning, warning.severity);
+  ASSERT_EQ(2U, warning.line);
+  ASSERT_EQ(1U, warning.column);
+  ASSERT_EQ("Incomplete DRAW at end of input is ignored", warning.message);
+}
+
+TEST(Assembler, LoadsIntoEmulator) {
+  Assembler assembler;
+  ASSERT_EQ(true, assembler.assemble("SET r0 5\nADD r0 r0\nIDX 2F0\n"));
+
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadRom(assembler.getOutput().data(),
+                                   assembler.getOutput().size()));
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_EQ(true, emulator.tick());
+  }
+  ASSERT_EQ(10, emulator.getRegister(0));
+  ASSERT_EQ(0x2F0, emulator.getIndexRegister());
+  ASSERT_EQ(0x206, emulator.getProgramCounter());
+}
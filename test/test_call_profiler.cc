@@ -0,0 +1,95 @@
+#include <sstream>
+
+#include "gtest/gtest.h"
+#include "chip8core/CallProfiler.h"
+#include "chip8core/Emulator.h"
+
+TEST(CallProfiler, NestedCalls) {
+  byte const rom[] = {
+    0x22, 0x06,  // 0x200: CALL 0x206
+    0x22, 0x06,  // 0x202: CALL 0x206
+    0x12, 0x04,  // 0x204: JUMP 0x204
+    0x22, 0x0C,  // 0x206: CALL 0x20C
+    0x60, 0x01,  // 0x208: SET  r0 1
+    0x00, 0xEE,  // 0x20A: RTS
+    0x60, 0x02,  // 0x20C: SET  r0 2
+    0x00, 0xEE,  // 0x20E: RTS
+  };
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+
+  CallProfiler profiler;
+  profiler.observe(emulator);
+  for (unsigned i = 0; i < 20; ++i) {
+    ASSERT_EQ(true, profiler.tick(emulator));
+  }
+
+  std::vector<CallProfiler::Function> const functions = profiler.functions();
+  ASSERT_EQ(3U, functions.size());
+  ASSERT_EQ(0x200, functions.at(0).entry);
+  ASSERT_EQ(20U, functions.at(0).inclusive);
+  ASSERT_EQ(10U, functions.at(0).exclusive);
+  ASSERT_EQ(0x206, functions.at(1).entry);
+  ASSERT_EQ(2U, functions.at(1).calls);
+  ASSERT_EQ(10U, functions.at(1).inclusive);
+  ASSERT_EQ(6U, functions.at(1).exclusive);
+  ASSERT_EQ(0x20C, functions.at(2).entry);
+  ASSERT_EQ(2U, functions.at(2).calls);
+  ASSERT_EQ(4U, functions.at(2).inclusive);
+  ASSERT_EQ(4U, functions.at(2).exclusive);
+
+  std::stringstream ss;
+  profiler.writeFolded(ss);
+  ASSERT_EQ("200 10\n200;206 6\n200;206;20c 4\n", ss.str());
+}
+
+TEST(CallProfiler, Recursion) {
+  byte const rom[] = {
+    0x22, 0x02,  // 0x200: CALL 0x202
+    0x22, 0x02,  // 0x202: CALL 0x202
+  };
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+
+  CallProfiler profiler;
+  profiler.observe(emulator);
+  for (unsigned i = 0; i < 16; ++i) {
+    ASSERT_EQ(true, profiler.tick(emulator));
+  }
+  ASSERT_EQ(false, profiler.tick(emulator));
+
+  std::vector<CallProfiler::Function> const functions = profiler.functions();
+  ASSERT_EQ(2U, functions.size());
+  ASSERT_EQ(17U, functions.at(0).inclusive);
+  ASSERT_EQ(0x202, functions.at(1).entry);
+  ASSERT_EQ(16U, functions.at(1).calls);
+  ASSERT_EQ(16U, functions.at(1).inclusive);
+  ASSERT_EQ(16U, functions.at(1).exclusive);
+}
+
+TEST(CallProfiler, FollowsLoadedStates) {
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadFileToRam("../roms/BRIX"));
+  emulator.setSeed(1);
+
+  CallProfiler profiler;
+  profiler.observe(emulator);
+  for (unsigned i = 0; i < 5000; ++i) {
+    profiler.tick(emulator);
+  }
+
+  // Jumping back to the start state unwinds the shadow stack too
+  Emulator restart;
+  ASSERT_EQ(true, restart.loadFileToRam("../roms/BRIX"));
+  ASSERT_EQ(true, emulator.loadState(restart.saveState().data(), Emulator::state_size));
+  profiler.observe(emulator);
+  for (unsigned i = 0; i < 5000; ++i) {
+    profiler.tick(emulator);
+  }
+
+  uint64_t exclusive = 0;
+  for (CallProfiler::Function const& function : profiler.functions()) {
+    exclusive += function.exclusive;
+  }
+  ASSERT_EQ(10000U, exclusive);
+}
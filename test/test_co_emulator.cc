@@ -0,0 +1,79 @@
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+#include "chip8core/CoEmulator.h"
+
+class CoEmulatorRom : public Emulator {
+public:
+  explicit CoEmulatorRom(std::vector<halfword> const& program) {
+    halfword address = program_counter_start;
+    for (halfword opcode : program) {
+      ram.at(address++) = opcode >> 8;
+      ram.at(address++) = opcode & 0xFF;
+    }
+  }
+};
+
+// 0x200: WKEY r0, 0x202: CHAR r0, 0x204: DRAW r1 r1 5,
+// 0x206: SET r2 3, 0x208: SAUD r2, 0x20A: JMP 0x200
+static std::vector<halfword> const program{
+  0xF00A, 0xF029, 0xD115, 0x6203, 0xF218, 0x1200
+};
+
+static CoTask play(CoEmulator& emu, int key, std::vector<int>& log) {
+  for (int round = 0; round < 3; ++round) {
+    if (!co_await emu.keyWait()) { co_return; }
+    log.push_back(1);
+    emu.emulator().setKeyState(key, true);
+
+    if (!co_await emu.nextFrame()) { co_return; }
+    log.push_back(emu.emulator().getGraphicsData()[0]);
+
+    if (!co_await emu.sound()) { co_return; }
+    log.push_back(3);
+  }
+}
+
+TEST(CoEmulator, AwaitEvents) {
+  CoExecutor executor;
+  CoEmulator emu(executor, CoEmulatorRom(program));
+  std::vector<int> log;
+
+  executor.spawn(play(emu, 1, log));
+  executor.run();
+
+  // Font for 1 starts with 0x20, drawing it again clears it
+  std::vector<int> const expected{1, 0x20, 3, 1, 0x00, 3, 1, 0x20, 3};
+  ASSERT_EQ(expected, log);
+}
+
+TEST(CoEmulator, ManyEmulators) {
+  CoExecutor executor(16);
+  std::vector<std::unique_ptr<CoEmulator>> emulators;
+  std::vector<std::vector<int>> logs(50);
+
+  for (unsigned i = 0; i < logs.size(); ++i) {
+    emulators.emplace_back(new CoEmulator(executor, CoEmulatorRom(program)));
+    executor.spawn(play(*emulators.back(), 0xF, logs.at(i)));
+  }
+  executor.run(4);
+
+  std::vector<int> const expected{1, 0xF0, 3, 1, 0x00, 3, 1, 0xF0, 3};
+  for (std::vector<int> const& log : logs) {
+    ASSERT_EQ(expected, log);
+  }
+}
+
+TEST(CoEmulator, Fault) {
+  CoExecutor executor;
+  CoEmulator emu(executor, CoEmulatorRom({0x0123}));
+  std::vector<int> log;
+
+  executor.spawn(play(emu, 1, log));
+  executor.run();
+
+  ASSERT_TRUE(log.empty());
+  ASSERT_EQ("Opcode 0123 not implemented", emu.getError());
+}
@@ -0,0 +1,180 @@
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "gtest/gtest.h"
+#include "chip8core/DebugServer.h"
+
+static std::string const socket_path = "test_debug_server.sock";
+
+// Runs an emulator through a DebugServer on its own thread, as a host would
+class DebugServerTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    byte const rom[] = {
+      0x70, 0x01,  // 0x200: ADD  r0 1
+      0x12, 0x00,  // 0x202: JUMP 0x200
+    };
+    ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+    ASSERT_EQ(true, server.open(socket_path));
+    stop = false;
+    thread = std::thread([this]() {
+      while (!stop) {
+        server.tick(emulator);
+      }
+    });
+    ASSERT_EQ(true, client.connect(socket_path));
+  }
+
+  void TearDown() override {
+    client.disconnect();
+    stop = true;
+    thread.join();
+    server.close();
+  }
+
+  DebugStatus status() {
+    std::vector<byte> response;
+    EXPECT_EQ(true, client.request(DebugCommand::Status, 0, 0, {}, response));
+    EXPECT_EQ(DebugStatus::size, response.size());
+    return DebugStatus::read(response.data());
+  }
+
+  Emulator          emulator;
+  DebugServer       server;
+  DebugClient       client;
+  std::thread       thread;
+  std::atomic<bool> stop;
+};
+
+TEST_F(DebugServerTest, PauseStepContinue) {
+  ASSERT_EQ(true, client.request(DebugCommand::Pause, 0, 0));
+  DebugStatus const paused = status();
+  ASSERT_EQ(true, paused.paused);
+  ASSERT_EQ(paused.instruction_count, status().instruction_count);
+
+  ASSERT_EQ(true, client.request(DebugCommand::Step, 3, 0));
+  DebugStatus const stepped = status();
+  ASSERT_EQ(paused.instruction_count + 3, stepped.instruction_count);
+
+  ASSERT_EQ(true, client.request(DebugCommand::Continue, 0, 0));
+  while (status().instruction_count == stepped.instruction_count) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ(false, status().paused);
+}
+
+TEST_F(DebugServerTest, Breakpoint) {
+  ASSERT_EQ(true, client.request(DebugCommand::SetBreakpoint, 0x202, 1));
+  DebugStatus stopped = status();
+  while (stopped.stop_reason == StopReason::None) {
+    stopped = status();
+  }
+  ASSERT_EQ(StopReason::Breakpoint, stopped.stop_reason);
+  ASSERT_EQ(0x202, stopped.program_counter);
+  ASSERT_EQ(stopped.instruction_count, status().instruction_count);
+
+  // Steps over the breakpoint, then runs into it again
+  ASSERT_EQ(true, client.request(DebugCommand::Step, 5, 0));
+  DebugStatus const again = status();
+  ASSERT_EQ(StopReason::Breakpoint, again.stop_reason);
+  ASSERT_EQ(stopped.instruction_count + 2, again.instruction_count);
+  ASSERT_EQ(true, again.paused);
+
+  ASSERT_EQ(true, client.request(DebugCommand::ClearDebugPoints, 0, 0));
+  ASSERT_EQ(true, client.request(DebugCommand::Continue, 0, 0));
+  ASSERT_EQ(StopReason::None, status().stop_reason);
+}
+
+TEST_F(DebugServerTest, ReadAndWrite) {
+  ASSERT_EQ(true, client.request(DebugCommand::Pause, 0, 0));
+
+  std::vector<byte> const bytes = { 0x60, 0x2A };  // SET r0 42
+  std::vector<byte> response;
+  ASSERT_EQ(true, client.request(DebugCommand::WriteRam, 0x300, 0, bytes,
+                                 response));
+  ASSERT_EQ(true, client.request(DebugCommand::ReadRam, 0x300, 2, {},
+                                 response));
+  ASSERT_EQ(bytes, response);
+
+  ASSERT_EQ(true, client.request(DebugCommand::SetRegister, 17, 0x300));
+  ASSERT_EQ(true, client.request(DebugCommand::SetRegister, 16, 0x123));
+  ASSERT_EQ(true, client.request(DebugCommand::SetRegister, 5, 7));
+  ASSERT_EQ(true, client.request(DebugCommand::Step, 1, 0));
+  DebugStatus const stepped = status();
+  ASSERT_EQ(42, stepped.registers[0]);
+  ASSERT_EQ(7, stepped.registers[5]);
+  ASSERT_EQ(0x123, stepped.index_register);
+  ASSERT_EQ(0x302, stepped.program_counter);
+
+  std::vector<byte> const row = { 0xFF, 0x81 };
+  ASSERT_EQ(true, client.request(DebugCommand::WriteScreen, 8, 0, row,
+                                 response));
+  ASSERT_EQ(true, client.request(DebugCommand::ReadScreen, 8, 2, {},
+                                 response));
+  ASSERT_EQ(row, response);
+
+  ASSERT_EQ(false, client.request(DebugCommand::ReadRam, 0xFFF, 2, {},
+                                  response));
+  ASSERT_EQ("Out of range", client.getError());
+  ASSERT_EQ(false, client.request(DebugCommand::SetRegister, 18, 0));
+}
+
+TEST(DebugServer, NotResponding) {
+  DebugServer server;
+  ASSERT_EQ(true, server.open(socket_path));
+  DebugClient client;
+  ASSERT_EQ(true, client.connect(socket_path));
+  ASSERT_EQ(false, client.request(DebugCommand::Pause, 0, 0));
+  ASSERT_EQ("Emulator not responding", client.getError());
+  client.disconnect();
+  server.close();
+
+  ASSERT_EQ(false, client.connect(socket_path));
+}
+
+TEST(DebugServer, KeepsOtherFiles) {
+  std::string const file = "test_debug_server.txt";
+  std::FILE* out = std::fopen(file.c_str(), "w");
+  ASSERT_NE(nullptr, out);
+  std::fclose(out);
+
+  DebugServer server;
+  ASSERT_EQ(false, server.open(file));
+  ASSERT_EQ(file + " exists and is not a socket", server.getError());
+  out = std::fopen(file.c_str(), "r");
+  ASSERT_NE(nullptr, out);
+  std::fclose(out);
+  std::remove(file.c_str());
+}
+
+TEST(DebugServer, ReplacesOnlyStaleSockets) {
+  DebugServer first;
+  ASSERT_EQ(true, first.open(socket_path));
+  DebugServer second;
+  ASSERT_EQ(false, second.open(socket_path));
+  ASSERT_EQ(socket_path + " is in use by another server", second.getError());
+  DebugClient client;
+  ASSERT_EQ(true, client.connect(socket_path));
+  client.disconnect();
+  first.close();
+
+  // A socket left behind by a process which died without cleaning up
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  memcpy(address.sun_path, socket_path.c_str(), socket_path.size());
+  int const fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_LE(0, fd);
+  ASSERT_EQ(0, bind(fd, reinterpret_cast<sockaddr*>(&address),
+                    sizeof(address)));
+  close(fd);
+
+  ASSERT_EQ(true, second.open(socket_path));
+  second.close();
+}
@@ -0,0 +1,122 @@
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+
+TEST(EmulatorDebug, Breakpoint) {
+  byte const rom[] = {
+    0x60, 0x01,  // 0x200: SET  r0 1
+    0x70, 0x01,  // 0x202: ADD  r0 1
+    0x12, 0x02,  // 0x204: JUMP 0x202
+  };
+  Emulator emulator;
+  emulator.setBreakpoint(0x202, true);
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+  ASSERT_EQ(StopReason::None, emulator.getStopReason());
+
+  ASSERT_EQ(true, emulator.tick());
+  ASSERT_EQ(true, emulator.tick());
+  ASSERT_EQ(StopReason::Breakpoint, emulator.getStopReason());
+  ASSERT_EQ(0x202, emulator.getStopAddress());
+  ASSERT_EQ(0x202, emulator.getProgramCounter());
+  ASSERT_EQ(1, emulator.getRegister(0));
+
+  // Stays stopped until resumed
+  ASSERT_EQ(true, emulator.tick());
+  ASSERT_EQ(1U, emulator.getInstructionCount());
+
+  emulator.resume();
+  ASSERT_EQ(true, emulator.tick());
+  ASSERT_EQ(2, emulator.getRegister(0));
+  ASSERT_EQ(true, emulator.tick());
+  ASSERT_EQ(true, emulator.tick());
+  ASSERT_EQ(StopReason::Breakpoint, emulator.getStopReason());
+  ASSERT_EQ(3U, emulator.getInstructionCount());
+
+  emulator.setBreakpoint(0x202, false);
+  emulator.resume();
+  for (unsigned i = 0; i < 10; ++i) {
+    ASSERT_EQ(true, emulator.tick());
+  }
+  ASSERT_EQ(StopReason::None, emulator.getStopReason());
+  ASSERT_EQ(13U, emulator.getInstructionCount());
+}
+
+TEST(EmulatorDebug, WriteWatchpoint) {
+  byte const rom[] = {
+    0x60, 0x7B,  // 0x200: SET  r0 123
+    0xA3, 0x00,  // 0x202: LOADI 0x300
+    0xF0, 0x33,  // 0x204: BCD  r0
+    0xA3, 0x10,  // 0x206: LOADI 0x310
+    0xF2, 0x55,  // 0x208: STOR r2
+  };
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+  emulator.setWatchpoint(0x302, 1, WatchWrite, true);
+  emulator.setWatchpoint(0x311, 4, WatchReadWrite, true);
+
+  for (unsigned i = 0; i < 3; ++i) {
+    ASSERT_EQ(true, emulator.tick());
+  }
+  ASSERT_EQ(StopReason::WriteWatchpoint, emulator.getStopReason());
+  ASSERT_EQ(0x302, emulator.getStopAddress());
+  ASSERT_EQ(0x206, emulator.getProgramCounter());
+
+  emulator.resume();
+  ASSERT_EQ(true, emulator.tick());
+  ASSERT_EQ(StopReason::None, emulator.getStopReason());
+  ASSERT_EQ(true, emulator.tick());
+  ASSERT_EQ(StopReason::WriteWatchpoint, emulator.getStopReason());
+  ASSERT_EQ(0x311, emulator.getStopAddress());
+}
+
+TEST(EmulatorDebug, ReadWatchpoint) {
+  byte const rom[] = {
+    0xA0, 0x00,  // 0x200: LOADI 0x000, the font sprite for 0
+    0xD0, 0x05,  // 0x202: DRAW r0 r0 5
+    0xF1, 0x65,  // 0x204: LOAD r1
+  };
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+  emulator.setWatchpoint(0x004, 1, WatchRead, true);
+  emulator.setWatchpoint(0x001, 1, WatchWrite, true);
+
+  ASSERT_EQ(true, emulator.tick());
+  ASSERT_EQ(true, emulator.tick());
+  ASSERT_EQ(StopReason::ReadWatchpoint, emulator.getStopReason());
+  ASSERT_EQ(0x004, emulator.getStopAddress());
+
+  // Only reads of the first two bytes, none of which are watched for reads
+  emulator.resume();
+  ASSERT_EQ(true, emulator.tick());
+  ASSERT_EQ(StopReason::None, emulator.getStopReason());
+
+  emulator.clearDebugPoints();
+  emulator.setWatchpoint(0x004, 1, WatchRead, true);
+  emulator.setWatchpoint(0x004, 1, WatchRead, false);
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+  for (unsigned i = 0; i < 3; ++i) {
+    ASSERT_EQ(true, emulator.tick());
+  }
+  ASSERT_EQ(StopReason::None, emulator.getStopReason());
+}
+
+TEST(EmulatorDebug, ForkCopiesDebugPoints) {
+  byte const rom[] = {
+    0x12, 0x00,  // 0x200: JUMP 0x200
+  };
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+  Emulator child = emulator.fork();
+  child.setBreakpoint(0x200, true);
+
+  ASSERT_EQ(true, emulator.tick());
+  ASSERT_EQ(StopReason::None, emulator.getStopReason());
+  ASSERT_EQ(true, child.tick());
+  ASSERT_EQ(StopReason::Breakpoint, child.getStopReason());
+}
+
+TEST(EmulatorDebug, OutOfRange) {
+  Emulator emulator;
+  ASSERT_THROW(emulator.setBreakpoint(0x1000, true), std::out_of_range);
+  ASSERT_THROW(emulator.setWatchpoint(0xFFE, 4, WatchRead, true),
+               std::out_of_range);
+}
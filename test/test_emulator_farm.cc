@@ -0,0 +1,134 @@
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+#include "chip8core/EmulatorFarm.h"
+
+class EmulatorFarmRom : public Emulator {
+public:
+  explicit EmulatorFarmRom(std::vector<halfword> const& program) {
+    halfword address = program_counter_start;
+    for (halfword opcode : program) {
+      ram.at(address++) = opcode >> 8;
+      ram.at(address++) = opcode & 0xFF;
+    }
+  }
+};
+
+TEST(EmulatorFarm, FrameLimit) {
+  EmulatorFarm farm(2, 10);
+  EmulatorFarm::StopCondition stop;
+  stop.max_frames = 5;
+
+  // 0x200: JMP 0x200
+  std::size_t id = farm.add(EmulatorFarmRom({0x1200}), stop);
+  EmulatorFarm::Summary summary = farm.run();
+
+  ASSERT_EQ(1U, summary.instances);
+  ASSERT_EQ(1U, summary.frame_limit);
+  ASSERT_EQ(EmulatorFarm::StopReason::FrameLimit, farm.result(id).reason);
+  ASSERT_EQ(5U, farm.result(id).frames);
+  ASSERT_EQ(50U, farm.result(id).ticks);
+}
+
+TEST(EmulatorFarm, ProgramCounter) {
+  EmulatorFarm farm(1, 10);
+  EmulatorFarm::StopCondition stop;
+  stop.stop_at_pc = true;
+  stop.program_counter = 0x206;
+
+  // 0x200: SET r0 5, 0x202: ADD r0 1, 0x204: JMP 0x206, 0x206: JMP 0x206
+  std::size_t id = farm.add(EmulatorFarmRom({0x6005, 0x7001, 0x1206, 0x1206}), stop);
+  farm.run();
+
+  ASSERT_EQ(EmulatorFarm::StopReason::ProgramCounter, farm.result(id).reason);
+  ASSERT_EQ(3U, farm.result(id).ticks);
+  ASSERT_EQ(0x206, farm.result(id).program_counter);
+}
+
+TEST(EmulatorFarm, ScreenHash) {
+  EmulatorFarm farm(1, 4);
+  EmulatorFarm::StopCondition stop;
+  stop.max_frames = 100;
+
+  // 0x200: CHAR r0, 0x202: DRAW r0 r0 5, 0x204: JMP 0x204
+  EmulatorFarmRom rom({0xF029, 0xD005, 0x1204});
+  std::size_t reference = farm.add(rom, stop);
+  farm.run();
+  uint64_t const hash = farm.result(reference).screen_hash;
+  ASSERT_NE(EmulatorFarm::screenHash(Emulator()), hash);
+
+  stop.stop_at_screen_hash = true;
+  stop.screen_hash = hash;
+  std::size_t id = farm.add(rom, stop);
+  farm.run();
+
+  ASSERT_EQ(EmulatorFarm::StopReason::ScreenHash, farm.result(id).reason);
+  ASSERT_EQ(1U, farm.result(id).frames);
+}
+
+TEST(EmulatorFarm, Error) {
+  EmulatorFarm farm(1, 10);
+  std::size_t id = farm.add(EmulatorFarmRom({0x0123}), EmulatorFarm::StopCondition());
+  EmulatorFarm::Summary summary = farm.run();
+
+  ASSERT_EQ(1U, summary.errors);
+  ASSERT_EQ(EmulatorFarm::StopReason::Error, farm.result(id).reason);
+  ASSERT_EQ("Opcode 0123 not implemented", farm.result(id).error);
+}
+
+TEST(EmulatorFarm, ThrowingRom) {
+  EmulatorFarm farm(2, 10);
+  // IDX FFF, SEP r0 writes past the end of RAM
+  std::size_t bad = farm.add(EmulatorFarmRom({0xAFFF, 0xF033}),
+                             EmulatorFarm::StopCondition());
+  EmulatorFarm::StopCondition stop;
+  stop.max_frames = 5;
+  std::size_t good = farm.add(EmulatorFarmRom({0x1200}), stop);
+  EmulatorFarm::Summary summary = farm.run();
+
+  ASSERT_EQ(1U, summary.errors);
+  ASSERT_EQ(EmulatorFarm::StopReason::Error, farm.result(bad).reason);
+  ASSERT_EQ(false, farm.result(bad).error.empty());
+  ASSERT_EQ(EmulatorFarm::StopReason::FrameLimit, farm.result(good).reason);
+}
+
+TEST(EmulatorFarm, ManyInstances) {
+  EmulatorFarm farm(4, 16);
+  for (unsigned i = 0; i < 200; ++i) {
+    EmulatorFarm::StopCondition stop;
+    stop.max_frames = 1 + i % 7;
+    farm.add(EmulatorFarmRom({0x7001, 0x1200}), stop);
+  }
+
+  EmulatorFarm::Summary summary = farm.run();
+  ASSERT_EQ(200U, summary.instances);
+  ASSERT_EQ(200U, summary.frame_limit);
+  for (unsigned i = 0; i < farm.size(); ++i) {
+    ASSERT_EQ(1 + i % 7, farm.result(i).frames);
+  }
+}
+
+TEST(EmulatorFarm, AddRomNotFound) {
+  EmulatorFarm farm;
+  ASSERT_EQ(false, farm.addRom("", EmulatorFarm::StopCondition()));
+  ASSERT_EQ(": File empty or not found", farm.getError());
+  ASSERT_EQ(0U, farm.size());
+}
+
+TEST(EmulatorFarm, AddSharedRom) {
+  std::shared_ptr<RomImage> rom(new RomImage);
+  ASSERT_EQ(true, rom->mapFile("../roms/PONG"));
+  SharedRomImage const shared = rom;
+
+  EmulatorFarm farm(4);
+  EmulatorFarm::StopCondition stop;
+  stop.max_frames = 10;
+  for (unsigned i = 0; i < 64; ++i) {
+    ASSERT_EQ(true, farm.addRom(*shared, stop));
+  }
+
+  EmulatorFarm::Summary const summary = farm.run();
+  ASSERT_EQ(64U, summary.frame_limit);
+  for (unsigned i = 0; i < farm.size(); ++i) {
+    ASSERT_EQ(10U, farm.result(i).frames);
+  }
+}
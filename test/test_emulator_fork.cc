@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+
+class EmulatorFork : public ::testing::Test, public Emulator {
+};
+
+TEST_F(EmulatorFork, SharesRam) {
+  ASSERT_EQ(true, loadFileToRam("../roms/PONG"));
+  Emulator child = fork();
+
+  for (unsigned page = 0; page < ram_size / ram_page_size; ++page) {
+    ASSERT_TRUE(ram.isShared(page));
+  }
+  ASSERT_EQ(saveState(), child.saveState());
+}
+
+TEST_F(EmulatorFork, CopyOnWrite) {
+  // 0x200: IDX 0x800, 0x202: SET r0 0x42, 0x204: STOR 0
+  ram.at(0x200) = 0xA8; ram.at(0x201) = 0x00;
+  ram.at(0x202) = 0x60; ram.at(0x203) = 0x42;
+  ram.at(0x204) = 0xF0; ram.at(0x205) = 0x55;
+
+  Emulator child = fork();
+  for (unsigned i = 0; i < 3; ++i) {
+    ASSERT_EQ(true, child.tick());
+  }
+
+  // The program page is still shared, the written page is the child's own
+  ASSERT_TRUE(ram.isShared(0x200 / ram_page_size));
+  // RAM starts after the 8 byte save state header
+  ASSERT_EQ(0x42, child.saveState().at(8 + 0x800));
+  ASSERT_EQ(0x00, ram.get(0x800));
+  ASSERT_EQ(0x200, program_counter);
+}
+
+TEST_F(EmulatorFork, NoCallbacks) {
+  onGraphics = []() {};
+  error_msg = "Some error";
+  Emulator child = fork();
+
+  ASSERT_TRUE(child.onGraphics == nullptr);
+  ASSERT_TRUE(child.onSound == nullptr);
+  ASSERT_EQ("", child.getError());
+}
+
+TEST_F(EmulatorFork, DeepTree) {
+  ASSERT_EQ(true, loadFileToRam("../roms/BRIX"));
+  setSeed(1);
+
+  std::vector<Emulator> branches;
+  branches.push_back(fork());
+  for (unsigned depth = 0; depth < 1000; ++depth) {
+    branches.push_back(branches.back().fork());
+    branches.back().setKeyState(depth % num_keys, depth % 2);
+    for (unsigned i = 0; i < 20; ++i) {
+      branches.back().tick();
+    }
+  }
+
+  // Every branch still has its own state
+  Emulator replay = fork();
+  for (unsigned depth = 0; depth < 1000; ++depth) {
+    replay.setKeyState(depth % num_keys, depth % 2);
+    for (unsigned i = 0; i < 20; ++i) {
+      replay.tick();
+    }
+    ASSERT_EQ(branches.at(depth + 1).saveState(), replay.saveState());
+  }
+}
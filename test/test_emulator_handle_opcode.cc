@@ -366,6 +366,22 @@ TEST_F(EmulatorHandleOpcode, OP_0xCXNN) {
   }
 }
 
+TEST_F(EmulatorHandleOpcode, OP_0xCXNN_Seeded) {
+  setSeed(1234);
+
+  std::vector<byte> first;
+  for (unsigned i = 0; i < 32; ++i) {
+    ASSERT_EQ(true, handleOpcode(0xC0FF));
+    first.push_back(registers.at(0));
+  }
+
+  setSeed(1234);
+  for (unsigned i = 0; i < 32; ++i) {
+    ASSERT_EQ(true, handleOpcode(0xC0FF));
+    ASSERT_EQ(first.at(i), registers.at(0));
+  }
+}
+
 TEST_F(EmulatorHandleOpcode, OP_0xDXYN) {
   ram.at(index_register) = 0x12;
   ram.at(index_register + 1) = 0x34;
@@ -189,3 +189,19 @@ TEST_F(EmulatorInitialization, KeysState) {
     ASSERT_EQ(0U, i);
   }
 }
+
+TEST_F(EmulatorInitialization, LoadRomKeepsSeed) {
+  byte const rom[] = { 0xC0, 0xFF, 0xC1, 0xFF };  // RND r0 FF, RND r1 FF
+  setSeed(5);
+  ASSERT_EQ(true, loadRom(rom, sizeof(rom)));
+  ASSERT_EQ(true, tick());
+  ASSERT_EQ(true, tick());
+  byte const first = registers.at(0);
+  byte const second = registers.at(1);
+
+  ASSERT_EQ(true, loadRom(rom, sizeof(rom)));
+  ASSERT_EQ(true, tick());
+  ASSERT_EQ(true, tick());
+  ASSERT_EQ(first, registers.at(0));
+  ASSERT_EQ(second, registers.at(1));
+}
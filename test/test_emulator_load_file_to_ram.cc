@@ -66,3 +66,39 @@ TEST_F(EmulatorLoadFileToRam, LoadDataCorrectly) {
   EXPECT_EQ(0xCD, ram.at(0x200 + 6));
   EXPECT_EQ(0xEF, ram.at(0x200 + 7));
 }
+
+TEST_F(EmulatorLoadFileToRam, LoadRomFromBuffer) {
+  byte const data[] = { 0x12, 0x34, 0x56 };
+  ASSERT_EQ(true, loadRom(data, sizeof(data)));
+  EXPECT_EQ(0x12, ram.get(0x200));
+  EXPECT_EQ(0x34, ram.get(0x201));
+  EXPECT_EQ(0x56, ram.get(0x202));
+  EXPECT_EQ(0x00, ram.get(0x203));
+
+  ASSERT_EQ(false, loadRom(data, 0));
+  ASSERT_EQ("ROM is empty", error_msg);
+
+  std::vector<byte> const too_big(ram_size - 0x200 + 1, 'c');
+  ASSERT_EQ(false, loadRom(too_big.data(), too_big.size()));
+  ASSERT_EQ("ROM too big. Only 3584 bytes available. ROM is 3585 bytes",
+            error_msg);
+}
+
+TEST_F(EmulatorLoadFileToRam, LoadRomFromImage) {
+  RomImage mapped;
+  ASSERT_EQ(true, mapped.mapFile("../test/atof.txt"));
+  setSeed(1);
+  ASSERT_EQ(true, loadRom(mapped));
+  EXPECT_EQ(0x01, ram.get(0x200));
+  EXPECT_EQ(0xEF, ram.get(0x207));
+
+  RomImage copied;
+  copied.assign(mapped.data(), mapped.size());
+  Emulator other;
+  other.setSeed(1);
+  ASSERT_EQ(true, other.loadRom(copied));
+  ASSERT_EQ(saveState(), other.saveState());
+
+  ASSERT_EQ(false, mapped.mapFile("../test/not_a_file"));
+  ASSERT_EQ("File empty or not found", mapped.getError());
+}
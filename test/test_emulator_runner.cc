@@ -0,0 +1,71 @@
+#include <chrono>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+#include "chip8core/EmulatorRunner.h"
+
+class EmulatorRunnerRom : public Emulator {
+public:
+  explicit EmulatorRunnerRom(std::vector<halfword> const& program) {
+    halfword address = program_counter_start;
+    for (halfword opcode : program) {
+      ram.at(address++) = opcode >> 8;
+      ram.at(address++) = opcode & 0xFF;
+    }
+  }
+};
+
+static bool waitForEvent(EmulatorRunner& runner, EmulatorRunner::Event& event) {
+  for (unsigned i = 0; i < 2000; ++i) {
+    if (runner.pollEvent(event)) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return false;
+}
+
+TEST(EmulatorRunner, KeyToFrame) {
+  // 0x200: WKEY r0, 0x202: CHAR r0, 0x204: DRAW r1 r1 5, 0x206: JMP 0x206
+  EmulatorRunner runner(EmulatorRunnerRom({0xF00A, 0xF029, 0xD115, 0x1206}),
+                        6000, 600);
+  runner.start();
+  ASSERT_EQ(false, runner.pushKey(16, true));
+
+  // Keys pressed before WKEY has run are not picked up, so keep pressing
+  EmulatorRunner::Event event;
+  bool got_event = false;
+  for (unsigned i = 0; i < 2000 && !got_event; ++i) {
+    runner.pushKey(7, true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    got_event = runner.pollEvent(event);
+  }
+  ASSERT_EQ(true, got_event);
+  ASSERT_EQ(EmulatorRunner::Event::Type::Frame, event.type);
+
+  // Font for 7
+  ASSERT_EQ(0xF0, event.screen[0 * Emulator::screen_columns]);
+  ASSERT_EQ(0x10, event.screen[1 * Emulator::screen_columns]);
+  ASSERT_EQ(0x20, event.screen[2 * Emulator::screen_columns]);
+  ASSERT_EQ(0x40, event.screen[3 * Emulator::screen_columns]);
+  ASSERT_EQ(0x40, event.screen[4 * Emulator::screen_columns]);
+  runner.stop();
+  ASSERT_EQ(false, runner.isRunning());
+}
+
+TEST(EmulatorRunner, SoundAndFault) {
+  // 0x200: SET r0 2, 0x202: SAUD r0, 0x204: JMP 0x206, 0x206: <invalid>
+  EmulatorRunner runner(EmulatorRunnerRom({0x6002, 0xF018, 0x1206, 0x0123}),
+                        6000, 600);
+  runner.start();
+
+  EmulatorRunner::Event event;
+  ASSERT_EQ(true, waitForEvent(runner, event));
+  ASSERT_EQ(EmulatorRunner::Event::Type::Sound, event.type);
+
+  ASSERT_EQ(true, waitForEvent(runner, event));
+  ASSERT_EQ(EmulatorRunner::Event::Type::Fault, event.type);
+  ASSERT_STREQ("Opcode 0123 not implemented", event.error);
+  ASSERT_EQ(0U, runner.droppedEvents());
+}
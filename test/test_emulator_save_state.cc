@@ -0,0 +1,85 @@
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+
+class EmulatorSaveState : public ::testing::Test, public Emulator {
+};
+
+TEST_F(EmulatorSaveState, BufferTooSmall) {
+  std::vector<byte> buffer(state_size - 1);
+  ASSERT_EQ(0U, saveState(buffer.data(), buffer.size()));
+  ASSERT_EQ(state_size, saveState().size());
+}
+
+TEST_F(EmulatorSaveState, RoundTrip) {
+  ASSERT_EQ(true, loadFileToRam("../roms/PONG"));
+  setSeed(99);
+  for (unsigned i = 0; i < 500; ++i) {
+    ASSERT_EQ(true, tick());
+  }
+  setKeyState(3, true);
+
+  std::vector<byte> state(state_size);
+  ASSERT_EQ(state_size, saveState(state.data(), state.size()));
+
+  for (unsigned i = 0; i < 500; ++i) {
+    ASSERT_EQ(true, tick());
+  }
+  std::vector<byte> const later = saveState();
+  ASSERT_NE(state, later);
+
+  // Going back and running again gives the same result
+  ASSERT_EQ(true, loadState(state.data(), state.size()));
+  ASSERT_EQ(state, saveState());
+  for (unsigned i = 0; i < 500; ++i) {
+    ASSERT_EQ(true, tick());
+  }
+  ASSERT_EQ(later, saveState());
+}
+
+TEST_F(EmulatorSaveState, Fields) {
+  registers.at(4) = 0x44;
+  index_register = 0x345;
+  program_counter = 0x456;
+  stack.at(2) = 0x567;
+  stack_pointer = 3;
+  delay_timer = 7;
+  sound_timer = 8;
+  keys_state.at(9) = 0xFF;
+  awaiting_keypress = true;
+  awaiting_keypress_register = 5;
+  ram.at(0xFFF) = 0xAB;
+  screen.at(0xFF) = 0xCD;
+  std::vector<byte> const state = saveState();
+
+  Emulator other;
+  ASSERT_EQ(true, other.loadState(state.data(), state.size()));
+  ASSERT_EQ(state, other.saveState());
+  ASSERT_EQ(0x456, other.getProgramCounter());
+  ASSERT_EQ(true, other.isAwaitingKeypress());
+  ASSERT_EQ(0xCD, other.getGraphicsData()[0xFF]);
+}
+
+TEST_F(EmulatorSaveState, Invalid) {
+  std::vector<byte> state = saveState();
+  std::vector<byte> const original = state;
+
+  ASSERT_EQ(false, loadState(state.data(), state.size() - 1));
+  ASSERT_EQ("Not a save state", error_msg);
+
+  state.at(0) = 'X';
+  ASSERT_EQ(false, loadState(state.data(), state.size()));
+  ASSERT_EQ("Not a save state", error_msg);
+
+  state = original;
+  state.at(4) = 2;
+  ASSERT_EQ(false, loadState(state.data(), state.size()));
+  ASSERT_EQ("Unsupported save state version 2", error_msg);
+
+  // Stack pointer past the stack
+  state = original;
+  state.at(state_size - 10) = stack_size + 1;
+  ASSERT_EQ(false, loadState(state.data(), state.size()));
+  ASSERT_EQ("Corrupt save state", error_msg);
+
+  ASSERT_EQ(original, saveState());
+}
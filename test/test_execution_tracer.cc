@@ -0,0 +1,153 @@
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+#include "chip8core/ExecutionTracer.h"
+
+static std::string const filename = "test_execution_tracer.bin";
+
+TEST(ExecutionTracer, Records) {
+  byte const rom[] = {
+    0xA3, 0x00,  // 0x200: IDX  0x300
+    0x65, 0x2A,  // 0x202: SET  r5 0x2A
+    0x12, 0x04,  // 0x204: JUMP 0x204
+  };
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+
+  ExecutionTracer tracer(4);
+  for (unsigned i = 0; i < 3; ++i) {
+    ASSERT_EQ(true, tracer.tick(emulator));
+  }
+
+  std::vector<TraceRecord> records = tracer.snapshot();
+  ASSERT_EQ(3U, records.size());
+  ASSERT_EQ(0x200, records.at(0).program_counter);
+  ASSERT_EQ(0xA300, records.at(0).opcode);
+  ASSERT_EQ(0x300, records.at(0).index_register);
+  ASSERT_EQ(false, records.at(0).has_register);
+  ASSERT_EQ(true, records.at(1).has_register);
+  ASSERT_EQ(5, records.at(1).register_number);
+  ASSERT_EQ(0x2A, records.at(1).register_value);
+  ASSERT_EQ(0x204, records.at(2).program_counter);
+  ASSERT_EQ(false, records.at(2).fault);
+
+  // Only the newest records fit in the ring, less the one an append may be
+  // overwriting
+  for (unsigned i = 0; i < 10; ++i) {
+    tracer.tick(emulator);
+  }
+  records = tracer.snapshot();
+  ASSERT_EQ(13U, tracer.recorded());
+  ASSERT_EQ(3U, records.size());
+  ASSERT_EQ(0x1204, records.at(0).opcode);
+}
+
+TEST(ExecutionTracer, SnapshotDuringAppend) {
+  byte const rom[] = {
+    0x70, 0x01,  // 0x200: ADD  r0 1
+    0x12, 0x00,  // 0x202: JUMP 0x200
+  };
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+
+  ExecutionTracer tracer(16);
+  std::atomic<bool> done(false);
+  std::thread writer([&]() {
+    for (unsigned i = 0; i < 1000000; ++i) {
+      tracer.tick(emulator);
+    }
+    done = true;
+  });
+
+  // Every snapshot has to be an unbroken run of the loop
+  bool consistent = true;
+  while (!done && consistent) {
+    std::vector<TraceRecord> const records = tracer.snapshot();
+    for (std::size_t i = 1; i < records.size(); ++i) {
+      TraceRecord const& previous = records[i - 1];
+      TraceRecord const& record = records[i];
+      consistent &= record.opcode != previous.opcode;
+      if (i >= 2 && record.opcode == 0x7001) {
+        consistent &= record.register_value
+          == static_cast<byte>(records[i - 2].register_value + 1);
+      }
+    }
+  }
+  writer.join();
+  ASSERT_EQ(true, consistent);
+}
+
+TEST(ExecutionTracer, SpillOnFault) {
+  byte const rom[] = {
+    0x60, 0x07,  // 0x200: SET  r0 7
+    0x00, 0xEE,  // 0x202: RTS, which underflows the stack
+  };
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+
+  ExecutionTracer tracer;
+  tracer.setFaultFile(filename);
+  ASSERT_EQ(true, tracer.tick(emulator));
+  ASSERT_EQ(false, tracer.tick(emulator));
+  ASSERT_EQ(true, tracer.waitForSpill());
+
+  Trace trace;
+  ASSERT_EQ(true, trace.load(filename));
+  std::remove(filename.c_str());
+  ASSERT_EQ("Stack underflow", trace.fault);
+  ASSERT_EQ(2U, trace.records.size());
+  ASSERT_EQ(0x6007, trace.records.at(0).opcode);
+  ASSERT_EQ(true, trace.records.at(1).fault);
+
+  ASSERT_EQ(false, trace.load("../test/atof.txt"));
+  ASSERT_EQ("Not a trace", trace.getError());
+}
+
+TEST(ExecutionTracer, SpillOnThrow) {
+  byte const rom[] = {
+    0xAF, 0xFF,  // 0x200: IDX  0xFFF
+    0xF0, 0x33,  // 0x202: SEP  r0, which writes past the end of RAM
+  };
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+
+  ExecutionTracer tracer;
+  tracer.setFaultFile(filename);
+  ASSERT_EQ(true, tracer.tick(emulator));
+  ASSERT_THROW(tracer.tick(emulator), std::out_of_range);
+  ASSERT_EQ(true, tracer.waitForSpill());
+
+  Trace trace;
+  ASSERT_EQ(true, trace.load(filename));
+  std::remove(filename.c_str());
+  ASSERT_EQ(false, trace.fault.empty());
+  ASSERT_EQ(2U, trace.records.size());
+  ASSERT_EQ(0x202, trace.records.at(1).program_counter);
+  ASSERT_EQ(0xF033, trace.records.at(1).opcode);
+  ASSERT_EQ(true, trace.records.at(1).fault);
+}
+
+TEST(ExecutionTracer, ConcurrentSnapshots) {
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadFileToRam("../roms/BRIX"));
+  ExecutionTracer tracer(256);
+
+  std::thread runner([&]() {
+    for (unsigned i = 0; i < 200000; ++i) {
+      tracer.tick(emulator);
+    }
+  });
+  for (unsigned i = 0; i < 200; ++i) {
+    std::vector<TraceRecord> const records = tracer.snapshot();
+    ASSERT_GE(256U, records.size());
+    for (TraceRecord const& record : records) {
+      ASSERT_LE(0x200, record.program_counter);
+    }
+  }
+  runner.join();
+  ASSERT_EQ(255U, tracer.snapshot().size());
+}
@@ -0,0 +1,81 @@
+#include <cstdio>
+
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+#include "chip8core/InputLog.h"
+
+static InputLog record(Emulator& emulator) {
+  EXPECT_EQ(true, emulator.loadFileToRam("../roms/TANK"));
+  InputRecorder recorder(emulator, 1234);
+
+  for (unsigned frame = 0; frame < 300; ++frame) {
+    // Key events at odd points, also while waiting for a key
+    if (frame % 7 == 0) {
+      recorder.setKeyState((frame / 7) % Emulator::num_keys, frame % 2 == 0);
+    }
+    for (unsigned i = 0; i < 10 + frame % 3; ++i) {
+      emulator.tick();
+      if (i == 4 && frame % 11 == 0) {
+        recorder.setKeyState(5, true);
+      }
+    }
+    recorder.markFrame();
+  }
+  return recorder.log();
+}
+
+TEST(InputLog, Replay) {
+  Emulator recorded;
+  InputLog const log = record(recorded);
+  ASSERT_EQ(1234U, log.seed);
+  ASSERT_FALSE(log.key_events.empty());
+  ASSERT_EQ(300U, log.frame_hashes.size());
+
+  Emulator replayed;
+  ASSERT_EQ(true, replayed.loadFileToRam("../roms/TANK"));
+  replayed.setSeed(1);
+
+  InputReplayer replayer(replayed, log);
+  while (!replayer.finished()) {
+    ASSERT_EQ(true, replayer.tick()) << replayer.getError();
+  }
+  ASSERT_EQ(recorded.saveState(), replayed.saveState());
+}
+
+TEST(InputLog, Diverged) {
+  Emulator recorded;
+  InputLog log = record(recorded);
+  log.key_events.at(0).on = !log.key_events.at(0).on;
+
+  Emulator replayed;
+  ASSERT_EQ(true, replayed.loadFileToRam("../roms/TANK"));
+  InputReplayer replayer(replayed, log);
+
+  bool ok = true;
+  while (ok && !replayer.finished()) {
+    ok = replayer.tick();
+  }
+  ASSERT_EQ(false, ok);
+  ASSERT_EQ(0U, replayer.getError().find("Replay diverged at instruction "));
+}
+
+TEST(InputLog, SaveAndLoad) {
+  Emulator recorded;
+  InputLog log = record(recorded);
+  std::string const filename = "test_input_log.bin";
+  ASSERT_EQ(true, log.save(filename));
+
+  InputLog loaded;
+  ASSERT_EQ(true, loaded.load(filename));
+  std::remove(filename.c_str());
+
+  ASSERT_EQ(log.seed, loaded.seed);
+  ASSERT_EQ(log.start_state, loaded.start_state);
+  ASSERT_EQ(log.key_events.size(), loaded.key_events.size());
+  ASSERT_EQ(log.key_events.back().instruction, loaded.key_events.back().instruction);
+  ASSERT_EQ(log.frame_hashes.size(), loaded.frame_hashes.size());
+  ASSERT_EQ(log.frame_hashes.back().hash, loaded.frame_hashes.back().hash);
+
+  ASSERT_EQ(false, loaded.load("../test/atof.txt"));
+  ASSERT_EQ("Not an input log", loaded.getError());
+}
@@ -0,0 +1,122 @@
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+#include "chip8core/LockstepEmulator.h"
+
+class LockstepEmulatorLane : public Emulator {
+public:
+  void setDelayTimer(byte value) { delay_timer = value; }
+
+  void expectSameState(LockstepEmulatorLane const& other) const {
+    ASSERT_EQ(ram, other.ram);
+    ASSERT_EQ(screen, other.screen);
+    ASSERT_EQ(registers, other.registers);
+    ASSERT_EQ(index_register, other.index_register);
+    ASSERT_EQ(program_counter, other.program_counter);
+    ASSERT_EQ(sound_timer, other.sound_timer);
+    ASSERT_EQ(delay_timer, other.delay_timer);
+    ASSERT_EQ(stack, other.stack);
+    ASSERT_EQ(stack_pointer, other.stack_pointer);
+    ASSERT_EQ(keys_state, other.keys_state);
+    ASSERT_EQ(awaiting_keypress, other.awaiting_keypress);
+    ASSERT_EQ(error_msg, other.error_msg);
+  }
+};
+
+static void runAgainstEmulators(std::string const& rom, unsigned num_lanes,
+                                unsigned ticks) {
+  LockstepEmulator lockstep(num_lanes);
+  ASSERT_EQ(true, lockstep.loadFileToRam(rom));
+
+  std::vector<LockstepEmulatorLane> emulators(num_lanes);
+  for (unsigned lane = 0; lane < num_lanes; ++lane) {
+    ASSERT_EQ(true, emulators.at(lane).loadFileToRam(rom));
+    emulators.at(lane).setSeed(lane + 1);
+    lockstep.setSeed(lane, lane + 1);
+  }
+
+  for (unsigned tick = 0; tick < ticks; ++tick) {
+    // Different input per lane makes the lanes diverge
+    for (unsigned lane = 0; lane < num_lanes; ++lane) {
+      if ((tick + lane * 37) % 97 == 0) {
+        int const key = (tick / 97 + lane) % Emulator::num_keys;
+        bool const on = (tick / 3) % 2;
+        emulators.at(lane).setKeyState(key, on);
+        lockstep.setKeyState(lane, key, on);
+      }
+    }
+
+    bool all_ok = true;
+    for (LockstepEmulatorLane& emulator : emulators) {
+      all_ok &= emulator.tick();
+    }
+    ASSERT_EQ(all_ok, lockstep.tick());
+  }
+
+  for (unsigned lane = 0; lane < num_lanes; ++lane) {
+    LockstepEmulatorLane result;
+    lockstep.getLane(lane, result);
+    result.expectSameState(emulators.at(lane));
+  }
+}
+
+TEST(LockstepEmulator, SameAsEmulatorBrix) {
+  runAgainstEmulators("../roms/BRIX", 8, 5000);
+}
+
+TEST(LockstepEmulator, SameAsEmulatorInvaders) {
+  runAgainstEmulators("../roms/INVADERS", 16, 5000);
+}
+
+TEST(LockstepEmulator, SameAsEmulatorTetris) {
+  runAgainstEmulators("../roms/TETRIS", 32, 5000);
+}
+
+TEST(LockstepEmulator, StaysInLockstep) {
+  LockstepEmulator lockstep(16);
+  ASSERT_EQ(true, lockstep.loadFileToRam("../roms/MAZE"));
+  for (unsigned lane = 0; lane < lockstep.lanes(); ++lane) {
+    lockstep.setSeed(lane, 42);
+  }
+
+  for (unsigned tick = 0; tick < 1000; ++tick) {
+    ASSERT_EQ(true, lockstep.tick());
+  }
+  ASSERT_EQ(1000U, lockstep.getGroupCount());
+}
+
+TEST(LockstepEmulator, FailedLanes) {
+  LockstepEmulatorLane emulator;
+  LockstepEmulator lockstep(4);
+  lockstep.setLane(2, emulator);
+  lockstep.setLane(1, emulator);
+
+  // Fresh RAM at 0x200 is 0x0000, which is not implemented
+  ASSERT_EQ(false, lockstep.tick());
+  ASSERT_EQ(0xFU, lockstep.failedLanes());
+  ASSERT_EQ("Opcode 0000 not implemented", lockstep.getError(3));
+}
+
+TEST(LockstepEmulator, ProgramCounterOutOfBounds) {
+  LockstepEmulatorLane emulator;
+  emulator.setProgramCounter(0xFFF);
+  emulator.setDelayTimer(5);
+  LockstepEmulator lockstep(2);
+  lockstep.setLane(0, emulator);
+  lockstep.setLane(1, emulator);
+  emulator.setProgramCounter(0xFFE);
+  lockstep.setLane(1, emulator);
+
+  ASSERT_EQ(false, lockstep.tick());
+  ASSERT_EQ(0x3U, lockstep.failedLanes());
+  ASSERT_EQ("Program counter out of bounds", lockstep.getError(0));
+  ASSERT_EQ("Opcode 0000 not implemented", lockstep.getError(1));
+
+  LockstepEmulatorLane expected;
+  expected.setProgramCounter(0xFFF);
+  expected.setDelayTimer(5);
+  ASSERT_EQ(false, expected.tick());
+
+  LockstepEmulatorLane result;
+  lockstep.getLane(0, result);
+  result.expectSameState(expected);
+}
@@ -0,0 +1,39 @@
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+
+TEST(OpcodeCounters, CountsExecution) {
+  byte const rom[] = {
+    0x60, 0x05,  // SET  r0 5
+    0x30, 0x05,  // SKE  r0 5
+    0x00, 0x00,  // (skipped)
+    0x80, 0x14,  // ADD  r0 r1
+    0xF0, 0x29,  // FONT r0
+    0xD0, 0x05,  // DRAW r0 r0 5
+    0xD0, 0x05,  // DRAW r0 r0 5, which collides
+  };
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+  for (unsigned i = 0; i < 6; ++i) {
+    ASSERT_EQ(true, emulator.tick());
+  }
+
+  OpcodeCounters const counters = emulator.getOpcodeCounters();
+  if (!Emulator::has_opcode_counters) {
+    ASSERT_EQ(0U, counters.classes[0xD]);
+    ASSERT_EQ(0U, counters.skips);
+    return;
+  }
+
+  for (unsigned i = 0; i < 16; ++i) {
+    unsigned const expected = i == 0xD ? 2 : (i == 3 || i == 6 || i == 8 || i == 0xF);
+    ASSERT_EQ(expected, counters.classes[i]);
+  }
+  ASSERT_EQ(1U, counters.arithmetic[0x4]);
+  ASSERT_EQ(1U, counters.misc[0x29]);
+  ASSERT_EQ(1U, counters.skips);
+  ASSERT_EQ(10U, counters.sprite_rows);
+  ASSERT_EQ(1U, counters.collisions);
+
+  emulator.resetOpcodeCounters();
+  ASSERT_EQ(0U, emulator.getOpcodeCounters().classes[0xD]);
+}
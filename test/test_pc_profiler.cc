@@ -0,0 +1,81 @@
+#include <sstream>
+
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+#include "chip8core/PcProfiler.h"
+
+static Emulator loopRom() {
+  byte const rom[] = {
+    0x60, 0x00,  // 0x200: SET  r0 0
+    0x70, 0x01,  // 0x202: ADD  r0 1
+    0x30, 0x00,  // 0x204: SKE  r0 0
+    0x12, 0x02,  // 0x206: JUMP 0x202
+    0x12, 0x08,  // 0x208: JUMP 0x208
+  };
+  Emulator emulator;
+  EXPECT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+  return emulator;
+}
+
+TEST(PcProfiler, SamplesEveryInstruction) {
+  Emulator emulator = loopRom();
+  PcProfiler profiler;
+  for (unsigned i = 0; i < 1000; ++i) {
+    ASSERT_EQ(true, profiler.tick(emulator));
+  }
+
+  ASSERT_EQ(1000U, profiler.total());
+  // The counter wraps, and the loop is left by the 768th instruction
+  ASSERT_EQ(256U, profiler.count(0x202));
+  ASSERT_EQ(256U, profiler.count(0x204));
+  ASSERT_EQ(255U, profiler.count(0x206));
+  ASSERT_EQ(1000U - 767U, profiler.count(0x208));
+  ASSERT_EQ(0U, profiler.count(0x200));
+}
+
+TEST(PcProfiler, Interval) {
+  Emulator emulator = loopRom();
+  PcProfiler profiler(10);
+  for (unsigned i = 0; i < 1000; ++i) {
+    emulator.tick();
+    profiler.sample(emulator);
+  }
+  ASSERT_EQ(100U, profiler.total());
+
+  PcProfiler merged;
+  merged.merge(profiler);
+  merged.merge(profiler);
+  ASSERT_EQ(2 * profiler.total(), merged.total());
+  merged.reset();
+  ASSERT_EQ(0U, merged.total());
+}
+
+TEST(PcProfiler, RestartsAfterReload) {
+  Emulator emulator = loopRom();
+  PcProfiler profiler(10);
+  for (unsigned i = 0; i < 1000; ++i) {
+    ASSERT_EQ(true, profiler.tick(emulator));
+  }
+  ASSERT_EQ(100U, profiler.total());
+
+  emulator = loopRom();
+  for (unsigned i = 0; i < 100; ++i) {
+    ASSERT_EQ(true, profiler.tick(emulator));
+  }
+  ASSERT_EQ(110U, profiler.total());
+}
+
+TEST(PcProfiler, Report) {
+  Emulator emulator = loopRom();
+  PcProfiler profiler;
+  for (unsigned i = 0; i < 1000; ++i) {
+    profiler.tick(emulator);
+  }
+
+  std::stringstream ss;
+  profiler.report(ss, emulator, 2);
+  ASSERT_EQ("Samples: 1000 (every 1 instructions)\n"
+            "         256   25.6%  L202: 7001 - reg[0] += 01\n"
+            "         256   25.6%  L204: 3000 - IF reg[0] != 00:\n",
+            ss.str());
+}
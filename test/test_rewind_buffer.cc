@@ -0,0 +1,96 @@
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+#include "chip8core/RewindBuffer.h"
+
+static std::vector<std::vector<byte>> captureFrames(RewindBuffer& rewind,
+                                                    unsigned num_frames) {
+  Emulator emulator;
+  EXPECT_EQ(true, emulator.loadFileToRam("../roms/BLINKY"));
+  emulator.setSeed(7);
+
+  std::vector<std::vector<byte>> states;
+  for (unsigned frame = 0; frame < num_frames; ++frame) {
+    for (unsigned i = 0; i < 10; ++i) {
+      emulator.tick();
+    }
+    emulator.setKeyState(frame % Emulator::num_keys, frame % 3 == 0);
+    rewind.capture(emulator);
+    states.push_back(emulator.saveState());
+  }
+  return states;
+}
+
+TEST(RewindBuffer, RestoreEveryFrame) {
+  RewindBuffer rewind(1024 * 1024, 16);
+  std::vector<std::vector<byte>> const states = captureFrames(rewind, 200);
+  ASSERT_EQ(200U, rewind.size());
+
+  Emulator emulator;
+  for (std::size_t back = 0; back < states.size(); ++back) {
+    ASSERT_EQ(true, rewind.restore(back, emulator));
+    ASSERT_EQ(states.at(states.size() - 1 - back), emulator.saveState());
+  }
+
+  ASSERT_EQ(false, rewind.restore(200, emulator));
+  ASSERT_EQ("Only 200 frames available", rewind.getError());
+}
+
+TEST(RewindBuffer, DeltasAreSmall) {
+  RewindBuffer rewind(1024 * 1024, 1000);
+  captureFrames(rewind, 100);
+  ASSERT_LT(rewind.memoryUsed(), 100 * Emulator::state_size / 10);
+}
+
+TEST(RewindBuffer, MemoryLimit) {
+  std::size_t const limit = 64 * 1024;
+  RewindBuffer rewind(limit, 10);
+  std::vector<std::vector<byte>> const states = captureFrames(rewind, 2000);
+
+  ASSERT_LE(rewind.memoryUsed(), limit);
+  ASSERT_GT(rewind.size(), 10U);
+  ASSERT_LT(rewind.size(), 2000U);
+
+  Emulator emulator;
+  for (std::size_t back = 0; back < rewind.size(); ++back) {
+    ASSERT_EQ(true, rewind.restore(back, emulator));
+    ASSERT_EQ(states.at(states.size() - 1 - back), emulator.saveState());
+  }
+}
+
+TEST(RewindBuffer, MemoryLimitWhilePaused) {
+  // Unchanged frames are tiny, so the frame index has to be limited too
+  std::size_t const limit = 64 * 1024;
+  RewindBuffer rewind(limit, 60);
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadFileToRam("../roms/BLINKY"));
+  for (unsigned frame = 0; frame < 5000; ++frame) {
+    rewind.capture(emulator);
+  }
+
+  ASSERT_LE(rewind.memoryUsed(), limit);
+  ASSERT_LT(rewind.size(), limit / 8);
+  ASSERT_EQ(true, rewind.restore(rewind.size() - 1, emulator));
+}
+
+TEST(RewindBuffer, DiscardNewest) {
+  RewindBuffer rewind(1024 * 1024, 8);
+  std::vector<std::vector<byte>> states = captureFrames(rewind, 50);
+
+  rewind.discardNewest(13);
+  states.resize(states.size() - 13);
+  ASSERT_EQ(states.size(), rewind.size());
+
+  // Capture from the restored state again
+  Emulator emulator;
+  ASSERT_EQ(true, rewind.restore(0, emulator));
+  for (unsigned frame = 0; frame < 20; ++frame) {
+    emulator.tick();
+    rewind.capture(emulator);
+    states.push_back(emulator.saveState());
+  }
+
+  for (std::size_t back = 0; back < states.size(); ++back) {
+    ASSERT_EQ(true, rewind.restore(back, emulator));
+    ASSERT_EQ(states.at(states.size() - 1 - back), emulator.saveState());
+  }
+}
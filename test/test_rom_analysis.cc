@@ -0,0 +1,84 @@
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+#include "chip8core/RomAnalysis.h"
+
+class RomAnalysisTest : public ::testing::Test, public Emulator {
+};
+
+TEST(RomAnalysis, ControlFlow) {
+  byte const rom[] = {
+    0x60, 0x01,  // 0x200: SET  r0 1
+    0x30, 0x01,  // 0x202: SKE  r0 1
+    0x12, 0x0A,  // 0x204: JUMP 0x20A
+    0x22, 0x10,  // 0x206: CALL 0x210
+    0x12, 0x08,  // 0x208: JUMP 0x208
+    0x00, 0xE0,  // 0x20A: CLS
+    0x12, 0x08,  // 0x20C: JUMP 0x208
+    0xFF, 0xFF,  // 0x20E: data
+    0x00, 0xEE,  // 0x210: RTS
+    0xAB, 0xCD,  // 0x212: data
+  };
+  RomAnalysis const analysis(rom, sizeof(rom));
+
+  ASSERT_EQ(sizeof(rom), analysis.size());
+  ASSERT_EQ(RomAnalysis::contentHash(rom, sizeof(rom)), analysis.hash());
+  ASSERT_EQ(0x2210, analysis.opcode(0x206));
+  ASSERT_EQ(true, analysis.contains(0x212));
+  ASSERT_EQ(false, analysis.contains(0x213));
+  ASSERT_EQ(false, analysis.contains(0x1FE));
+
+  std::vector<uint16_t> const blocks = { 0x200, 0x204, 0x206, 0x208, 0x20A, 0x210 };
+  ASSERT_EQ(blocks, analysis.blockStarts());
+
+  for (uint16_t address : { 0x208, 0x20A, 0x210 }) {
+    ASSERT_EQ(true, analysis.isJumpTarget(address));
+  }
+  ASSERT_EQ(false, analysis.isJumpTarget(0x206));
+
+  for (uint16_t address = 0x200; address < 0x214; ++address) {
+    bool const data = address == 0x20E || address == 0x20F || address >= 0x212;
+    ASSERT_EQ(!data, analysis.isCode(address));
+    ASSERT_EQ(!data && address % 2 == 0, analysis.isInstruction(address));
+  }
+}
+
+TEST(RomAnalysis, SharedBetweenInstances) {
+  byte const rom[] = { 0x12, 0x00, 0x01, 0x02, 0x03 };
+  std::size_t const cached = RomAnalysis::cacheSize();
+  {
+    Emulator first;
+    Emulator second;
+    ASSERT_EQ(true, first.loadRom(rom, sizeof(rom)));
+    ASSERT_EQ(true, second.loadRom(rom, sizeof(rom)));
+    ASSERT_NE(nullptr, first.getRomAnalysis());
+    ASSERT_EQ(first.getRomAnalysis(), second.getRomAnalysis());
+    ASSERT_EQ(cached + 1, RomAnalysis::cacheSize());
+  }
+  ASSERT_EQ(cached, RomAnalysis::cacheSize());
+}
+
+TEST_F(RomAnalysisTest, SelfModifyingCode) {
+  byte const rom[] = {
+    0xA2, 0x08,  // 0x200: IDX  0x208
+    0x60, 0x70,  // 0x202: SET  r0 0x70
+    0x61, 0x07,  // 0x204: SET  r1 0x07
+    0xF1, 0x55,  // 0x206: STOR r1, which makes 0x208 ADD r0 0x07
+    0x60, 0x00,  // 0x208: SET  r0 0
+  };
+  ASSERT_EQ(true, loadRom(rom, sizeof(rom)));
+  for (unsigned i = 0; i < 4; ++i) {
+    ASSERT_EQ(true, tick());
+  }
+
+  // A fresh emulator restored from this state must notice the change too
+  Emulator restored;
+  ASSERT_EQ(true, restored.loadRom(rom, sizeof(rom)));
+  ASSERT_EQ(true, restored.loadState(saveState().data(), state_size));
+
+  ASSERT_EQ(true, tick());
+  ASSERT_EQ(0x77, registers.at(0));
+  ASSERT_EQ(0x6000, getRomAnalysis()->opcode(0x208));
+
+  ASSERT_EQ(true, restored.tick());
+  ASSERT_EQ(saveState(), restored.saveState());
+}
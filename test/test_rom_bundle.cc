@@ -0,0 +1,70 @@
+#include <cstdio>
+
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+#include "chip8core/RomAnalysis.h"
+#include "chip8core/RomBundle.h"
+
+static std::string const filename = "test_rom_bundle.bin";
+
+TEST(RomBundle, PackAndLoad) {
+  std::vector<std::string> const names = { "PONG", "BRIX", "TETRIS", "MAZE" };
+  RomBundleWriter writer;
+  for (std::string const& name : names) {
+    RomImage rom;
+    ASSERT_EQ(true, rom.mapFile("../roms/" + name));
+    writer.add(name, rom.data(), rom.size(), name == "BRIX" ? 0x5 : 0);
+  }
+  ASSERT_EQ(true, writer.write(filename));
+
+  RomBundle bundle;
+  ASSERT_EQ(true, bundle.open(filename));
+  std::remove(filename.c_str());
+  ASSERT_EQ(names.size(), bundle.size());
+
+  // Sorted by name
+  ASSERT_EQ("BRIX", bundle.entry(0).name);
+  ASSERT_EQ("TETRIS", bundle.entry(3).name);
+  ASSERT_EQ(0x5U, bundle.entry(0).quirks);
+  ASSERT_EQ(0x0U, bundle.entry(1).quirks);
+
+  for (std::string const& name : names) {
+    std::size_t const index = bundle.find(name);
+    ASSERT_NE(RomBundle::npos, index);
+    RomBundle::Entry const entry = bundle.entry(index);
+    ASSERT_EQ(name, entry.name);
+    ASSERT_EQ(RomAnalysis::contentHash(entry.data, entry.size), entry.hash);
+
+    Emulator from_bundle;
+    Emulator from_file;
+    ASSERT_EQ(true, from_bundle.loadRom(entry.data, entry.size));
+    ASSERT_EQ(true, from_file.loadFileToRam("../roms/" + name));
+    from_bundle.setSeed(1);
+    from_file.setSeed(1);
+    ASSERT_EQ(from_file.saveState(), from_bundle.saveState());
+  }
+
+  ASSERT_EQ(RomBundle::npos, bundle.find("PON"));
+  ASSERT_EQ(RomBundle::npos, bundle.find("PONGG"));
+  ASSERT_EQ(RomBundle::npos, bundle.find(""));
+  ASSERT_THROW(bundle.entry(4), std::out_of_range);
+}
+
+TEST(RomBundle, Empty) {
+  RomBundleWriter writer;
+  ASSERT_EQ(true, writer.write(filename));
+
+  RomBundle bundle;
+  ASSERT_EQ(true, bundle.open(filename));
+  std::remove(filename.c_str());
+  ASSERT_EQ(0U, bundle.size());
+  ASSERT_EQ(RomBundle::npos, bundle.find("PONG"));
+}
+
+TEST(RomBundle, BadFiles) {
+  RomBundle bundle;
+  ASSERT_EQ(false, bundle.open("../test/not_a_file"));
+  ASSERT_EQ("File empty or not found", bundle.getError());
+  ASSERT_EQ(false, bundle.open("../test/atof.txt"));
+  ASSERT_EQ("Not a ROM bundle", bundle.getError());
+}
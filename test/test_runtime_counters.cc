@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+
+TEST(RuntimeCounters, CountsExecution) {
+  byte const rom[] = {
+    0x60, 0x02,  // 0x200: SET  r0 2
+    0xF0, 0x15,  // 0x202: DELAY r0
+    0xF0, 0x29,  // 0x204: FONT r0
+    0xD0, 0x05,  // 0x206: DRAW r0 r0 5
+    0xD0, 0x05,  // 0x208: DRAW r0 r0 5, which collides
+    0x00, 0xE0,  // 0x20A: CLS
+    0xF1, 0x0A,  // 0x20C: KEYD r1
+    0x00, 0xEE,  // 0x20E: RTS, which underflows the stack
+  };
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+  unsigned graphics = 0;
+  emulator.onGraphics = [&graphics]() { ++graphics; };
+
+  for (unsigned i = 0; i < 7; ++i) {
+    ASSERT_EQ(true, emulator.tick());
+  }
+  for (unsigned i = 0; i < 3; ++i) {
+    ASSERT_EQ(true, emulator.tick());
+  }
+  emulator.setKeyState(1, true);
+  ASSERT_EQ(false, emulator.tick());
+  ASSERT_EQ(FaultType::StackUnderflow, emulator.getFault());
+
+  RuntimeCounters const& counters = emulator.getRuntimeCounters();
+  ASSERT_EQ(11U, counters.ticks);
+  ASSERT_EQ(7U, counters.instructions);
+  ASSERT_EQ(3U, counters.idle_ticks);
+  ASSERT_EQ(3U, counters.frames);
+  ASSERT_EQ(2U, counters.draws);
+  ASSERT_EQ(1U, counters.collisions);
+  ASSERT_EQ(1U, counters.timer_underflows);
+  ASSERT_EQ(3U, counters.graphics_callbacks);
+  ASSERT_EQ(3U, graphics);
+  ASSERT_EQ(0U, counters.sound_callbacks);
+  ASSERT_EQ(1U, counters.faults[static_cast<unsigned>(FaultType::StackUnderflow)]);
+  ASSERT_EQ(0U, counters.faults[static_cast<unsigned>(FaultType::UnknownOpcode)]);
+
+  emulator.resetRuntimeCounters();
+  ASSERT_EQ(0U, emulator.getRuntimeCounters().ticks);
+  ASSERT_EQ(8U, emulator.getInstructionCount());
+}
+
+TEST(RuntimeCounters, FaultTypes) {
+  byte const rom[] = {
+    0x01, 0x23,  // 0x200: RCA 1802 call, which is not implemented
+  };
+  Emulator emulator;
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+  ASSERT_EQ(false, emulator.tick());
+  ASSERT_EQ(FaultType::UnknownOpcode, emulator.getFault());
+
+  byte const runaway[] = {
+    0x1F, 0xFF,  // 0x200: JUMP 0xFFF
+  };
+  ASSERT_EQ(true, emulator.loadRom(runaway, sizeof(runaway)));
+  ASSERT_EQ(true, emulator.tick());
+  ASSERT_EQ(FaultType::None, emulator.getFault());
+  ASSERT_EQ(false, emulator.tick());
+  ASSERT_EQ(FaultType::ProgramCounterOutOfBounds, emulator.getFault());
+  ASSERT_EQ("Program counter out of bounds", emulator.getError());
+  ASSERT_EQ(1U, emulator.getRuntimeCounters().faults[
+    static_cast<unsigned>(FaultType::ProgramCounterOutOfBounds)]);
+}
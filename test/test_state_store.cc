@@ -0,0 +1,95 @@
+#include <cstdio>
+#include <fstream>
+
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+#include "chip8core/StateStore.h"
+
+static std::string const filename = "test_state_store.bin";
+
+static std::vector<std::vector<byte>> fillStore(unsigned num_states) {
+  std::remove(filename.c_str());
+  StateStore store;
+  EXPECT_EQ(true, store.open(filename, true));
+
+  Emulator emulator;
+  EXPECT_EQ(true, emulator.loadFileToRam("../roms/BRIX"));
+  emulator.setSeed(3);
+
+  std::vector<std::vector<byte>> states;
+  for (unsigned i = 0; i < num_states; ++i) {
+    for (unsigned j = 0; j < 50; ++j) {
+      emulator.tick();
+    }
+    EXPECT_EQ(true, store.append(emulator, 1000 + i));
+    states.push_back(emulator.saveState());
+  }
+  EXPECT_EQ(num_states, store.size());
+  return states;
+}
+
+TEST(StateStore, AppendAndRestore) {
+  std::vector<std::vector<byte>> const states = fillStore(100);
+
+  StateStore store;
+  ASSERT_EQ(true, store.open(filename));
+  ASSERT_EQ(100U, store.size());
+
+  Emulator emulator;
+  for (std::size_t i = states.size(); i-- > 0; ) {
+    ASSERT_EQ(1000 + i, store.key(i));
+    ASSERT_EQ(true, store.restore(i, emulator));
+    ASSERT_EQ(states.at(i), emulator.saveState());
+  }
+
+  ASSERT_EQ(false, store.restore(100, emulator));
+  ASSERT_EQ("Only 100 records available", store.getError());
+  ASSERT_EQ(false, store.append(emulator));
+  ASSERT_EQ("State store not open for writing", store.getError());
+  std::remove(filename.c_str());
+}
+
+TEST(StateStore, AppendToExisting) {
+  std::vector<std::vector<byte>> const states = fillStore(3);
+
+  StateStore store;
+  ASSERT_EQ(true, store.open(filename, true));
+  Emulator emulator;
+  ASSERT_EQ(true, store.append(emulator, 7));
+  ASSERT_EQ(4U, store.size());
+
+  ASSERT_EQ(true, store.restore(2, emulator));
+  ASSERT_EQ(states.at(2), emulator.saveState());
+  ASSERT_EQ(7U, store.key(3));
+  std::remove(filename.c_str());
+}
+
+TEST(StateStore, Checksum) {
+  fillStore(3);
+  {
+    // Flip one byte of RAM in the second record
+    std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(StateStore::header_size + StateStore::record_size + 8 + 8 + 0x300);
+    file.put(0x55);
+  }
+
+  StateStore store;
+  ASSERT_EQ(true, store.open(filename));
+  ASSERT_EQ(true, store.verify(0));
+  ASSERT_EQ(false, store.verify(1));
+
+  Emulator emulator;
+  std::vector<byte> const before = emulator.saveState();
+  ASSERT_EQ(false, store.restore(1, emulator));
+  ASSERT_EQ("Checksum mismatch in record 1", store.getError());
+  ASSERT_EQ(before, emulator.saveState());
+  std::remove(filename.c_str());
+}
+
+TEST(StateStore, BadFiles) {
+  StateStore store;
+  ASSERT_EQ(false, store.open("../test/not_a_file"));
+  ASSERT_EQ("File not found", store.getError());
+  ASSERT_EQ(false, store.open("../test/atof.txt"));
+  ASSERT_EQ("Not a state store", store.getError());
+}
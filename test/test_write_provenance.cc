@@ -0,0 +1,89 @@
+#include "gtest/gtest.h"
+#include "chip8core/Emulator.h"
+#include "chip8core/WriteProvenance.h"
+
+TEST(WriteProvenance, Queries) {
+  WriteProvenance provenance;
+  provenance.recordRam(0x300, 2, 0x204, 10);
+  provenance.recordRam(0x301, 1, 0x208, 20);
+
+  WriteProvenance::Write write;
+  ASSERT_EQ(false, provenance.lastRamWrite(0x300, 10, write));
+  ASSERT_EQ(true, provenance.lastRamWrite(0x300, 11, write));
+  ASSERT_EQ(0x204, write.program_counter);
+  ASSERT_EQ(10U, write.instruction);
+
+  ASSERT_EQ(true, provenance.lastRamWrite(0x301, 20, write));
+  ASSERT_EQ(0x204, write.program_counter);
+  ASSERT_EQ(true, provenance.lastRamWrite(0x301, UINT64_MAX, write));
+  ASSERT_EQ(0x208, write.program_counter);
+  ASSERT_EQ(20U, write.instruction);
+
+  ASSERT_EQ(false, provenance.lastRamWrite(0x302, UINT64_MAX, write));
+  ASSERT_EQ(false, provenance.lastScreenChange(0, UINT64_MAX, write));
+  ASSERT_EQ(3U, provenance.size());
+
+  provenance.clear();
+  ASSERT_EQ(0U, provenance.size());
+  ASSERT_EQ(false, provenance.lastRamWrite(0x300, UINT64_MAX, write));
+}
+
+TEST(WriteProvenance, RecordsEmulatorWrites) {
+  byte const rom[] = {
+    0x60, 0x7B,  // 0x200: SET  r0 123
+    0xA3, 0x00,  // 0x202: LOADI 0x300
+    0xF0, 0x33,  // 0x204: BCD  r0
+    0xF1, 0x55,  // 0x206: STOR r1
+    0xA0, 0x00,  // 0x208: LOADI 0x000, the font sprite for 0
+    0x61, 0x04,  // 0x20A: SET  r1 4
+    0xD1, 0x15,  // 0x20C: DRAW r1 r1 5
+    0x00, 0xE0,  // 0x20E: CLS
+  };
+  WriteProvenance provenance;
+  Emulator emulator;
+  emulator.setWriteProvenance(&provenance);
+  provenance.recordRam(0, 1, 0, 0);
+  ASSERT_EQ(true, emulator.loadRom(rom, sizeof(rom)));
+  ASSERT_EQ(0U, provenance.size());
+
+  for (unsigned i = 0; i < 7; ++i) {
+    ASSERT_EQ(true, emulator.tick());
+  }
+
+  // Forks and copies do not record
+  Emulator child = emulator.fork();
+  ASSERT_EQ(true, child.tick());
+  Emulator copy(emulator);
+  ASSERT_EQ(true, copy.tick());
+  Emulator assigned;
+  assigned = emulator;
+  ASSERT_EQ(true, assigned.tick());
+  ASSERT_EQ(3U + 2U + 5U, provenance.size());
+
+  ASSERT_EQ(true, emulator.tick());
+
+  WriteProvenance::Write write;
+  ASSERT_EQ(true, provenance.lastRamWrite(0x300, UINT64_MAX, write));
+  ASSERT_EQ(0x206, write.program_counter);
+  ASSERT_EQ(3U, write.instruction);
+  ASSERT_EQ(true, provenance.lastRamWrite(0x300, 3, write));
+  ASSERT_EQ(0x204, write.program_counter);
+  ASSERT_EQ(true, provenance.lastRamWrite(0x302, UINT64_MAX, write));
+  ASSERT_EQ(0x204, write.program_counter);
+  ASSERT_EQ(false, provenance.lastRamWrite(0x303, UINT64_MAX, write));
+
+  // The sprite is 4 pixels wide at x = 4, so only the left byte of each
+  // row changes. Row 1 is 4 * 8 + 0.
+  std::size_t const row = 4 * Emulator::screen_columns;
+  ASSERT_EQ(true, provenance.lastScreenChange(row, 7, write));
+  ASSERT_EQ(0x20C, write.program_counter);
+  ASSERT_EQ(6U, write.instruction);
+  ASSERT_EQ(false, provenance.lastScreenChange(row + 1, UINT64_MAX, write));
+  ASSERT_EQ(true, provenance.lastScreenChange(row, UINT64_MAX, write));
+  ASSERT_EQ(0x20E, write.program_counter);
+  ASSERT_EQ(true, provenance.lastScreenChange(row + 4 * Emulator::screen_columns,
+                                              UINT64_MAX, write));
+  ASSERT_EQ(0x20E, write.program_counter);
+
+  ASSERT_EQ(3U + 2U + 5U + 5U, provenance.size());
+}